@@ -0,0 +1,46 @@
+#include "MemoryManager.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Alloc/free storm: keeps a pool of live blocks and replaces a random one
+// on every step, so nearly every operation splits or coalesces a block.
+
+static const size_t HEAP_SIZE = 1 << 24;
+static const size_t LIVE_BLOCKS = 20000;
+static const size_t OPERATIONS = 2000000;
+
+typedef int (MemoryManager::*AllocFn)(size_t);
+
+static void run(const char* name, AllocFn alloc) {
+    MemoryManager mm;
+    mm.init(HEAP_SIZE);
+
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<size_t> size(16, 512);
+    std::vector<int> live;
+
+    for (size_t i = 0; i < LIVE_BLOCKS; ++i)
+        live.push_back((mm.*alloc)(size(rng)));
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < OPERATIONS; ++i) {
+        size_t pick = rng() % live.size();
+        mm.free_block(live[pick]);
+        live[pick] = (mm.*alloc)(size(rng));
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+    std::cout << name << "," << OPERATIONS << "," << ms << ","
+              << ms * 1e6 / OPERATIONS << "\n";
+}
+
+int main() {
+    std::cout << "strategy,alloc_free_pairs,total_ms,ns_per_pair\n";
+    run("first", &MemoryManager::allocate_first_fit);
+    run("best", &MemoryManager::allocate_best_fit);
+    run("worst", &MemoryManager::allocate_worst_fit);
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include "MemoryManager.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Replays one alloc/free trace through first, best, worst fit and the buddy
+// allocator, and reports throughput next to the fragmentation each strategy
+// leaves behind.
+
+static const size_t HEAP_SIZE = 1 << 26;
+static const size_t OPERATIONS = 400000;
+
+struct Op {
+    bool alloc;
+    size_t size;   // alloc: requested size
+    size_t target; // free: index of the alloc op being freed
+};
+
+static std::vector<Op> make_trace() {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<size_t> small(8, 256);
+    std::uniform_int_distribution<size_t> large(257, 8192);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+
+    std::vector<Op> trace;
+    std::vector<size_t> live;
+
+    for (size_t i = 0; i < OPERATIONS; ++i) {
+        if (!live.empty() && coin(rng) < 0.45) {
+            size_t pick = rng() % live.size();
+            trace.push_back({false, 0, live[pick]});
+            live[pick] = live.back();
+            live.pop_back();
+        } else {
+            size_t size = coin(rng) < 0.8 ? small(rng) : large(rng);
+            live.push_back(trace.size());
+            trace.push_back({true, size, 0});
+        }
+    }
+
+    return trace;
+}
+
+typedef int (MemoryManager::*AllocFn)(size_t);
+
+static void run(const char* name, AllocFn alloc, const std::vector<Op>& trace) {
+    MemoryManager mm;
+    mm.init(HEAP_SIZE);
+    std::vector<int> ids(trace.size(), -1);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < trace.size(); ++i) {
+        const Op& op = trace[i];
+        if (op.alloc)
+            ids[i] = (mm.*alloc)(op.size);
+        else if (ids[op.target] != -1)
+            mm.free_block(ids[op.target]);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+    std::cout << name << "," << trace.size() << "," << ms << ","
+              << trace.size() / ms * 1000 << ","
+              << mm.allocation_failure_rate() * 100 << ","
+              << mm.internal_fragmentation() << ","
+              << mm.external_fragmentation() << ","
+              << mm.memory_utilization() << "\n";
+}
+
+int main() {
+    std::vector<Op> trace = make_trace();
+
+    std::cout << "strategy,ops,total_ms,ops_per_sec,failure_rate_pct,"
+                 "internal_frag_bytes,external_frag,utilization\n";
+    run("first", &MemoryManager::allocate_first_fit, trace);
+    run("best", &MemoryManager::allocate_best_fit, trace);
+    run("worst", &MemoryManager::allocate_worst_fit, trace);
+    run("buddy", &MemoryManager::allocate_buddy, trace);
+    return 0;
+}
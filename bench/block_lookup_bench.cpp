@@ -0,0 +1,50 @@
+#include "MemoryManager.h"
+#include "cache/CacheHierarchy.h"
+#include "vm/VirtualMemoryManager.h"
+#include <chrono>
+#include <iostream>
+
+// Replays page-hit accesses against heaps holding an increasing number of
+// live blocks. Every access translates through get_block_start, so the time
+// per access shows how block lookup scales with heap size.
+
+static const size_t PAGE_SIZE = 256;
+static const size_t RESIDENT_PAGES = 64;
+static const size_t ACCESSES = 2000000;
+
+int main() {
+    const size_t block_counts[] = {1000, 4000, 16000, 32000};
+
+    std::cout << "blocks,accesses,total_ms,ns_per_access\n";
+
+    for (size_t blocks : block_counts) {
+        MemoryManager mm;
+        mm.init(blocks * 16 + RESIDENT_PAGES * PAGE_SIZE);
+
+        // Fill the front of the heap so page frames land behind every block
+        for (size_t i = 0; i < blocks; ++i)
+            mm.allocate_first_fit(16);
+
+        CacheHierarchy caches(InclusionPolicy::NINE, 100);
+        caches.add_level("L1", 256, 64, 2, "LRU", 1);
+        caches.add_level("L2", 1024, 64, 4, "LRU", 10);
+        VirtualMemoryManager vmm(mm, caches, RESIDENT_PAGES * PAGE_SIZE, "LRU");
+
+        // Warm up: fault every page in once
+        std::streambuf* out = std::cout.rdbuf(nullptr);
+        for (size_t p = 0; p < RESIDENT_PAGES; ++p)
+            vmm.access(p * PAGE_SIZE);
+        std::cout.rdbuf(out);
+
+        auto begin = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < ACCESSES; ++i)
+            vmm.access((i % RESIDENT_PAGES) * PAGE_SIZE + (i & 0xff));
+        auto end = std::chrono::steady_clock::now();
+
+        double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+        std::cout << blocks << "," << ACCESSES << "," << ms << ","
+                  << ms * 1e6 / ACCESSES << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include "cache/Cache.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Cache::access throughput for a few geometries and every replacement
+// policy. The address stream mixes a hot working set with random misses
+// so that both the hit path and victim selection are exercised.
+
+static const size_t ACCESSES = 20000000;
+
+static void run(size_t size, size_t block, size_t ways, const char* policy,
+                const std::vector<size_t>& addresses) {
+    Cache cache(size, block, ways, policy);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t address : addresses)
+        cache.access(address);
+    auto end = std::chrono::steady_clock::now();
+
+    double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+    std::cout << size << "," << ways << "," << policy << "," << addresses.size() << ","
+              << ms << "," << ms * 1e6 / addresses.size() << "\n";
+}
+
+int main() {
+    std::mt19937_64 rng(5);
+    std::vector<size_t> addresses(ACCESSES);
+    for (size_t& address : addresses)
+        address = rng() % 8 ? rng() % (48 * 1024) : rng() % (64 * 1024 * 1024);
+
+    std::cout << "cache_bytes,ways,policy,accesses,total_ms,ns_per_access\n";
+    const char* policies[] = {"LRU", "FIFO", "PLRU", "SRRIP", "BRRIP", "LFU", "RANDOM"};
+    for (const char* policy : policies) {
+        run(32 * 1024, 64, 8, policy, addresses);
+        run(256 * 1024, 64, 16, policy, addresses);
+        run(2 * 1024 * 1024, 64, 32, policy, addresses);
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "MemoryManager.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Churns a heap kept about 90% full with blocks of mixed sizes, first with
+// compaction off, then compacting the whole heap on a failed request, then
+// in bounded steps. The failure rate shows the fragmentation recovered; the
+// longest step shows the pause that bounding the steps buys down.
+
+static const size_t MEMORY = (size_t)1 << 20;
+static const size_t OPERATIONS = 200000;
+
+struct Result {
+    size_t requests;
+    size_t failures;
+    size_t bytes_moved;
+    size_t longest_step;
+    double ns_per_op;
+};
+
+// Counts the moves of each request so the longest pause is known
+class StepRecorder : public RelocationListener {
+public:
+    size_t bytes = 0;
+    void on_relocate(int, size_t, size_t, size_t size) override {
+        bytes += size;
+    }
+};
+
+static Result run(bool compaction, size_t step_bytes) {
+    MemoryManager mm;
+    StepRecorder steps;
+    mm.init(MEMORY);
+    mm.set_relocation_listener(&steps);
+    mm.set_auto_compaction(compaction, step_bytes);
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<size_t> small(16, 256);
+    std::uniform_int_distribution<size_t> large(4096, 65536);
+    std::vector<int> live;
+    size_t live_bytes = 0;
+    std::vector<size_t> sizes;
+
+    Result r = {0, 0, 0, 0, 0.0};
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < OPERATIONS; ++i) {
+        if (live_bytes < MEMORY * 9 / 10 || live.empty()) {
+            size_t size = rng() % 8 ? small(rng) : large(rng);
+            steps.bytes = 0;
+            int id = mm.allocate_first_fit(size);
+            r.requests++;
+            if (steps.bytes > r.longest_step)
+                r.longest_step = steps.bytes;
+            if (id == -1) {
+                r.failures++;
+                continue;
+            }
+            live.push_back(id);
+            sizes.push_back(size);
+            live_bytes += size;
+        } else {
+            size_t victim = rng() % live.size();
+            mm.free_block(live[victim]);
+            live_bytes -= sizes[victim];
+            live[victim] = live.back();
+            sizes[victim] = sizes.back();
+            live.pop_back();
+            sizes.pop_back();
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    r.bytes_moved = mm.get_bytes_moved();
+    r.ns_per_op = std::chrono::duration<double, std::nano>(end - begin).count() / OPERATIONS;
+    return r;
+}
+
+int main() {
+    struct Config {
+        const char* name;
+        bool compaction;
+        size_t step_bytes;
+    };
+    const Config configs[] = {
+        {"off", false, 0},
+        {"full", true, 0},
+        {"step_64k", true, (size_t)64 << 10},
+        {"step_16k", true, (size_t)16 << 10},
+    };
+
+    std::cout << "compaction,requests,failure_rate,bytes_moved,longest_step_bytes,ns_per_op\n";
+    for (const Config& c : configs) {
+        Result r = run(c.compaction, c.step_bytes);
+        std::cout << c.name << "," << r.requests << "," << (double)r.failures / r.requests
+                  << "," << r.bytes_moved << "," << r.longest_step << "," << r.ns_per_op
+                  << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include "ConcurrentAllocator.h"
+#include "MemoryManager.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Each thread keeps a window of live objects and replaces a random one per
+// operation, mostly small sizes with 1% of 2-16 KB blocks; a tenth of the
+// frees go to objects allocated by the next thread. The same load runs
+// against one MemoryManager behind a global lock and against the
+// ConcurrentAllocator, from 1 thread up to twice the hardware threads.
+// Throughput per thread count shows how each scales; contended lock
+// acquisitions show where threads waited.
+
+static const size_t OPERATIONS = 400000;   // per thread
+static const size_t LIVE = 512;            // objects per thread
+static const size_t HEAP = (size_t)256 << 20;
+
+static size_t request_size(std::mt19937& rng) {
+    if (rng() % 100 == 0)
+        return 2048 + rng() % 14336;
+    return 8 + rng() % (rng() % 4 ? 120 : 1016);
+}
+
+// The baseline: every request takes the one lock. Objects are block ids.
+struct GlobalLockHeap {
+    std::mutex lock;
+    MemoryManager mm;
+    std::atomic<size_t> contended;
+
+    explicit GlobalLockHeap(size_t size) : contended(0) { mm.init(size); }
+
+    std::unique_lock<std::mutex> acquire() {
+        std::unique_lock<std::mutex> guard(lock, std::try_to_lock);
+        if (!guard.owns_lock()) {
+            contended++;
+            guard.lock();
+        }
+        return guard;
+    }
+    int allocate(size_t size) {
+        std::unique_lock<std::mutex> guard = acquire();
+        return mm.allocate_first_fit(size);
+    }
+    void free(int id) {
+        std::unique_lock<std::mutex> guard = acquire();
+        mm.free_block(id);
+    }
+};
+
+// Objects handed from one thread to the next, under their own lock
+struct Mailbox {
+    std::mutex lock;
+    std::vector<size_t> objects;
+};
+
+template <typename Allocate, typename Free>
+static double run(size_t threads, Allocate allocate, Free free) {
+    std::vector<Mailbox> mailboxes(threads);
+    std::vector<std::thread> workers;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::mt19937 rng(t + 1);
+            std::vector<size_t> live;
+            for (size_t i = 0; i < LIVE; ++i)
+                live.push_back(allocate(t, request_size(rng)));
+
+            std::vector<size_t> inbox;
+            for (size_t i = 0; i < OPERATIONS; ++i) {
+                size_t& slot = live[rng() % LIVE];
+                if (i % 10 == 0 && threads > 1) {
+                    Mailbox& next = mailboxes[(t + 1) % threads];
+                    std::lock_guard<std::mutex> guard(next.lock);
+                    next.objects.push_back(slot);
+                } else {
+                    free(t, slot);
+                }
+                slot = allocate(t, request_size(rng));
+
+                if (i % 64 == 0) {
+                    {
+                        std::lock_guard<std::mutex> guard(mailboxes[t].lock);
+                        inbox.swap(mailboxes[t].objects);
+                    }
+                    for (size_t object : inbox)
+                        free(t, object);
+                    inbox.clear();
+                }
+            }
+            for (size_t object : live)
+                free(t, object);
+        });
+    }
+    for (std::thread& worker : workers)
+        worker.join();
+    auto end = std::chrono::steady_clock::now();
+
+    // Leftovers in the mailboxes are freed by the caller's allocator
+    for (Mailbox& box : mailboxes) {
+        for (size_t object : box.objects)
+            free(0, object);
+    }
+
+    double seconds = std::chrono::duration<double>(end - begin).count();
+    return threads * OPERATIONS / seconds / 1e6;
+}
+
+int main() {
+    size_t hardware = std::max<unsigned>(1, std::thread::hardware_concurrency());
+    std::vector<size_t> thread_counts;
+    for (size_t t = 1; t < 2 * hardware; t *= 2)
+        thread_counts.push_back(t);
+    thread_counts.push_back(2 * hardware);
+
+    std::cout << "allocator,threads,mops_per_s,speedup,contended_locks,failed_requests\n";
+
+    double base = 0.0;
+    for (size_t threads : thread_counts) {
+        GlobalLockHeap heap(HEAP);
+        // Failed requests are kept as -1 and freeing them is a no-op
+        double mops = run(
+            threads,
+            [&](size_t, size_t size) { return (size_t)heap.allocate(size); },
+            [&](size_t, size_t id) { heap.free((int)id); });
+        if (threads == 1)
+            base = mops;
+        std::cout << "global_lock," << threads << "," << mops << "," << mops / base << ","
+                  << heap.contended << ","
+                  << heap.mm.get_alloc_failures() << "\n";
+    }
+
+    for (size_t threads : thread_counts) {
+        ConcurrentAllocator allocator(HEAP);
+        std::vector<ConcurrentAllocator::ThreadCache*> caches;
+        for (size_t t = 0; t < threads; ++t)
+            caches.push_back(new ConcurrentAllocator::ThreadCache(allocator));
+
+        double mops = run(
+            threads,
+            [&](size_t t, size_t size) { return caches[t]->allocate(size); },
+            [&](size_t t, size_t address) {
+                if (address != ConcurrentAllocator::NO_ADDRESS)
+                    caches[t]->free(address);
+            });
+        if (threads == 1)
+            base = mops;
+        for (ConcurrentAllocator::ThreadCache* cache : caches)
+            delete cache;
+
+        std::cout << "thread_caches," << threads << "," << mops << "," << mops / base << ","
+                  << allocator.get_contended() << "," << allocator.get_failures() << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include "MemoryManager.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+// Samples the fragmentation metrics after every allocation on heaps of
+// 1k-64k blocks, every other one freed, and compares the time per
+// allocation with sampling off. Constant overhead across heap sizes means
+// the metrics no longer scan the block list.
+
+static const size_t ALLOCATIONS = 20000;
+
+static double run(size_t blocks, size_t interval) {
+    MemoryManager mm;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> hole(16, 256);
+
+    mm.init(blocks * 600);
+    for (size_t i = 0; i < blocks; ++i)
+        mm.allocate_first_fit(i % 2 ? 32 : hole(rng));
+    for (int id = 1; id <= (int)blocks; id += 2)
+        mm.free_block(id);
+
+    mm.set_fragmentation_sampling(interval);
+    std::uniform_int_distribution<size_t> request(64, 1024);
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ALLOCATIONS; ++i)
+        mm.free_block(mm.allocate_first_fit(request(rng)));
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - begin).count() / ALLOCATIONS;
+}
+
+int main() {
+    std::cout << "blocks,allocations,ns_per_alloc_unsampled,ns_per_alloc_sampled\n";
+    for (size_t blocks = 1024; blocks <= 131072; blocks *= 4) {
+        std::cout << blocks << "," << ALLOCATIONS << "," << run(blocks, 0) << ","
+                  << run(blocks, 1) << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include "MemoryManager.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+// Measures allocation latency on a fragmented heap: 100k+ blocks where every
+// other block has been freed. Holes near the start of the heap are small and
+// most requests only fit further in. Each timed allocation is freed again so
+// the heap shape stays the same throughout.
+
+static const size_t BLOCKS = 120000;
+static const size_t ALLOCATIONS = 20000;
+
+typedef int (MemoryManager::*AllocFn)(size_t);
+
+static void run(const char* name, AllocFn alloc) {
+    MemoryManager mm;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> small_hole(16, 128);
+    std::uniform_int_distribution<size_t> large_hole(16, 1024);
+
+    mm.init(BLOCKS * 600);
+
+    for (size_t i = 0; i < BLOCKS; ++i) {
+        if (i % 2)
+            mm.allocate_first_fit(32);
+        else
+            mm.allocate_first_fit(i < BLOCKS * 3 / 4 ? small_hole(rng) : large_hole(rng));
+    }
+    for (int id = 1; id <= (int)BLOCKS; id += 2)
+        mm.free_block(id);
+
+    std::uniform_int_distribution<size_t> request(64, 1024);
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ALLOCATIONS; ++i) {
+        int id = (mm.*alloc)(request(rng));
+        mm.free_block(id);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+    std::cout << name << "," << BLOCKS << "," << ALLOCATIONS << "," << ms << ","
+              << ms * 1e6 / ALLOCATIONS << "\n";
+}
+
+int main() {
+    std::cout << "strategy,blocks,allocations,total_ms,ns_per_alloc_free\n";
+    run("first", &MemoryManager::allocate_first_fit);
+    run("best", &MemoryManager::allocate_best_fit);
+    run("worst", &MemoryManager::allocate_worst_fit);
+    return 0;
+}
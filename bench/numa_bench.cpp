@@ -0,0 +1,83 @@
+#include "MemoryManager.h"
+#include "cache/CacheHierarchy.h"
+#include "vm/VirtualMemoryManager.h"
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Two cores on a dual-socket topology each work on their own half of a
+// shared buffer, alternating accesses. The buffer is first touched either
+// by core 0 alone, as a serial initialization does, or by each core on its
+// own half. Every placement policy runs both, with and without migration,
+// and reports AMAT, the share of memory accesses that went to the remote
+// node and the pages migrated.
+
+static const size_t PAGE_SIZE = 4096;
+static const size_t NODE_MEMORY = (size_t)32 << 20;
+static const size_t FOOTPRINT = (size_t)16 << 20;
+static const size_t ACCESSES = 2000000;
+static const size_t LOCAL_LATENCY = 100;
+static const size_t REMOTE_LATENCY = 170;
+
+int main() {
+    struct Config {
+        const char* name;
+        NumaPolicy policy;
+        size_t bind_node;
+        size_t migrate_after;
+    };
+    const Config configs[] = {
+        {"first-touch", NumaPolicy::FIRST_TOUCH, 0, 0},
+        {"first-touch+migration", NumaPolicy::FIRST_TOUCH, 0, 8},
+        {"interleave", NumaPolicy::INTERLEAVE, 0, 0},
+        {"bind-0", NumaPolicy::BIND, 0, 0},
+    };
+    const char* inits[] = {"serial", "parallel"};
+
+    std::cout << "init,placement,amat,remote_fraction,migrations,page_faults\n";
+
+    for (const char* init : inits) {
+        for (const Config& c : configs) {
+            MemoryManager mm;
+            mm.init(NODE_MEMORY);
+            NumaTopology numa(2, NODE_MEMORY, LOCAL_LATENCY, REMOTE_LATENCY);
+
+            CacheHierarchy caches(InclusionPolicy::NINE, LOCAL_LATENCY);
+            caches.add_level("L1", 32768, 64, 8, "LRU", 4);
+            caches.add_level("L2", 1 << 20, 64, 16, "LRU", 14);
+            caches.set_cores(2);
+            caches.set_memory_model(&numa);
+
+            VirtualMemoryManager vmm(mm, caches, NODE_MEMORY, "LRU");
+            vmm.set_verbose(false);
+            vmm.set_paging(4, PAGE_SIZE);
+            vmm.set_numa(&numa);
+            vmm.set_numa_policy(c.policy, c.bind_node);
+            vmm.set_numa_migration(c.migrate_after);
+
+            const size_t half = FOOTPRINT / 2;
+            for (size_t address = 0; address < FOOTPRINT; address += PAGE_SIZE) {
+                vmm.set_core(init[0] == 's' ? 0 : address / half);
+                vmm.access(address, AccessType::WRITE);
+            }
+            numa.reset_stats();
+
+            std::mt19937_64 rng(1);
+            for (size_t i = 0; i < ACCESSES; ++i) {
+                size_t core = i % 2;
+                vmm.set_core(core);
+                vmm.access(core * half + (rng() % half & ~(size_t)63));
+            }
+
+            size_t local = 0, remote = 0;
+            for (size_t n = 0; n < numa.num_nodes(); ++n) {
+                local += numa.get_local_accesses(n);
+                remote += numa.get_remote_accesses(n);
+            }
+            std::cout << init << "," << c.name << "," << caches.amat() << ","
+                      << (double)remote / (local + remote) << "," << vmm.get_migrations()
+                      << "," << vmm.get_page_faults() << "\n";
+        }
+    }
+    return 0;
+}
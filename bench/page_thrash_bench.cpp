@@ -0,0 +1,56 @@
+#include "MemoryManager.h"
+#include "cache/CacheHierarchy.h"
+#include "vm/VirtualMemoryManager.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Faults pages in at random from footprints far larger than physical
+// memory, so nearly every access evicts. The time per access shows
+// whether eviction cost grows with the number of pages ever touched.
+// OPT is given the address stream up front; its precomputation is not
+// timed.
+
+static const size_t PAGE_SIZE = 256;
+static const size_t FRAMES = 1024;
+static const size_t ACCESSES = 1000000;
+
+int main() {
+    const char* policies[] = {"LRU", "FIFO", "CLOCK", "SECOND_CHANCE", "WSCLOCK", "OPT"};
+    const size_t footprints[] = {2048, 65536, 1048576};
+
+    std::cout << "policy,footprint_pages,accesses,page_faults,total_ms,ns_per_access\n";
+
+    for (const char* policy : policies) {
+        for (size_t pages : footprints) {
+            MemoryManager mm;
+            mm.init(FRAMES * PAGE_SIZE);
+
+            CacheHierarchy caches(InclusionPolicy::NINE, 100);
+            caches.add_level("L1", 256, 64, 2, "LRU", 1);
+            caches.add_level("L2", 1024, 64, 4, "LRU", 10);
+            VirtualMemoryManager vmm(mm, caches, FRAMES * PAGE_SIZE, policy);
+            vmm.set_verbose(false);
+
+            std::mt19937_64 rng(1);
+            std::vector<size_t> addresses(ACCESSES);
+            for (size_t& address : addresses)
+                address = (rng() % pages) * PAGE_SIZE;
+            if (vmm.get_policy() == PageReplacementPolicy::OPT)
+                vmm.set_future(addresses);
+
+            auto begin = std::chrono::steady_clock::now();
+            for (size_t address : addresses)
+                vmm.access(address);
+            auto end = std::chrono::steady_clock::now();
+
+            double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+            std::cout << policy << "," << pages << "," << ACCESSES << ","
+                      << vmm.get_page_faults() << "," << ms << ","
+                      << ms * 1e6 / ACCESSES << "\n";
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include "cache/Cache.h"
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Runs streaming and irregular address streams through an L1/L2 pair with
+// each prefetcher on L1 and reports how much of the miss latency it hides:
+// L1 AMAT and hit rate, plus useful, late and polluting prefetches.
+
+static const size_t ACCESSES = 2000000;
+static const size_t LINE = 64;
+
+struct Config {
+    const char* name;
+    bool enabled;
+    PrefetcherType type;
+    size_t degree;
+    size_t distance;
+};
+
+static void run(const char* workload, const Config& config,
+                const std::vector<size_t>& addresses) {
+    Cache L2(256 * 1024, LINE, 8, "LRU");
+    Cache L1(32 * 1024, LINE, 8, "LRU");
+    L1.set_next_level(&L2);
+
+    Prefetcher prefetcher(config.type, config.degree, config.distance);
+    if (config.enabled)
+        L1.set_prefetcher(&prefetcher);
+
+    for (size_t address : addresses)
+        L1.access(address);
+
+    const PrefetchStats& stats = L1.prefetch_stats();
+    std::cout << workload << "," << config.name << "," << config.degree << ","
+              << config.distance << "," << L1.amat() << "," << L1.hit_rate() << ","
+              << stats.issued << "," << stats.useful << "," << stats.late << ","
+              << stats.polluting << "\n";
+}
+
+int main() {
+    std::mt19937_64 rng(11);
+    std::vector<std::vector<size_t>> workloads(4, std::vector<size_t>(ACCESSES));
+    const char* names[] = {"sequential", "stride3", "four_streams", "random"};
+
+    for (size_t i = 0; i < ACCESSES; ++i) {
+        // 8-byte loads walking a large array
+        workloads[0][i] = i * 8;
+        // one load every third line
+        workloads[1][i] = i * 3 * LINE;
+        // four arrays read in lockstep, 16 MiB apart
+        workloads[2][i] = (i % 4) * (16 << 20) + (i / 4) * 16;
+        workloads[3][i] = rng() % (64 << 20);
+    }
+
+    const Config configs[] = {
+        {"none", false, PrefetcherType::NEXT_LINE, 0, 1},
+        {"next-line", true, PrefetcherType::NEXT_LINE, 1, 1},
+        {"next-line", true, PrefetcherType::NEXT_LINE, 2, 4},
+        {"stride", true, PrefetcherType::STRIDE, 1, 4},
+        {"stride", true, PrefetcherType::STRIDE, 2, 8},
+        {"stream", true, PrefetcherType::STREAM, 2, 4},
+        {"stream", true, PrefetcherType::STREAM, 4, 8},
+    };
+
+    std::cout << "workload,prefetcher,degree,distance,l1_amat,l1_hit_rate,"
+                 "issued,useful,late,polluting\n";
+    for (size_t w = 0; w < workloads.size(); ++w)
+        for (const Config& config : configs)
+            run(names[w], config, workloads[w]);
+    return 0;
+}
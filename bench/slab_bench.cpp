@@ -0,0 +1,83 @@
+#include "MemoryManager.h"
+#include "SlabAllocator.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Small-object-heavy trace: a handful of fixed sizes, allocated and freed
+// in random order. Compares serving every object from the block list with
+// serving them from slab caches.
+
+static const size_t HEAP_SIZE = 1 << 26;
+static const size_t OPERATIONS = 2000000;
+static const size_t SIZES[] = {16, 32, 48, 64, 128, 256};
+
+struct Op {
+    bool alloc;
+    size_t size;
+    size_t target;
+};
+
+static std::vector<Op> make_trace() {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    std::vector<Op> trace;
+    std::vector<size_t> live;
+
+    for (size_t i = 0; i < OPERATIONS; ++i) {
+        if (!live.empty() && coin(rng) < 0.48) {
+            size_t pick = rng() % live.size();
+            trace.push_back({false, 0, live[pick]});
+            live[pick] = live.back();
+            live.pop_back();
+        } else {
+            live.push_back(trace.size());
+            trace.push_back({true, SIZES[rng() % 6], 0});
+        }
+    }
+    return trace;
+}
+
+template <typename Alloc, typename Free>
+static void run(const char* name, const std::vector<Op>& trace, Alloc alloc, Free release) {
+    std::vector<int> ids(trace.size(), -1);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < trace.size(); ++i) {
+        if (trace[i].alloc)
+            ids[i] = alloc(trace[i].size);
+        else if (ids[trace[i].target] != -1)
+            release(ids[trace[i].target]);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+    std::cout << name << "," << trace.size() << "," << ms << ","
+              << ms * 1e6 / trace.size() << "\n";
+}
+
+int main() {
+    std::vector<Op> trace = make_trace();
+    std::cout << "allocator,ops,total_ms,ns_per_op\n";
+
+    {
+        MemoryManager mm;
+        mm.init(HEAP_SIZE);
+        run("first_fit", trace,
+            [&](size_t size) { return mm.allocate_first_fit(size); },
+            [&](int id) { mm.free_block(id); });
+    }
+
+    {
+        MemoryManager mm;
+        mm.init(HEAP_SIZE);
+        SlabAllocator slab(mm);
+        run("slab", trace,
+            [&](size_t size) { return slab.allocate(size); },
+            [&](int id) { slab.free(id); });
+        slab.print_stats();
+    }
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+#ifndef BUDDY_ALLOCATOR_H
+#define BUDDY_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+// Binary buddy allocator over a power-of-two arena.
+// Offsets are relative to the start of the arena; the owner maps them to
+// physical addresses. Each order has an address-ordered free list and a
+// bitmap of free blocks, so finding a block's buddy is a single bit test.
+class BuddyAllocator {
+private:
+	static const size_t MIN_ORDER = 4; // 16-byte minimum block
+	static const size_t MAX_ORDER = 63; // largest block a size_t can hold
+
+	struct Allocation {
+		size_t offset;
+		size_t order;
+		size_t requested;
+	};
+
+	size_t max_order;
+	std::vector<std::set<size_t>> free_lists;
+	std::vector<std::vector<uint64_t>> free_bitmaps;
+	uint64_t nonempty_orders;
+
+	std::unordered_map<int, Allocation> allocations;
+	size_t allocated_bytes;
+	size_t requested_bytes;
+
+	static size_t order_for(size_t size);
+	bool is_free(size_t offset, size_t order) const;
+	void push_free(size_t offset, size_t order);
+	void remove_free(size_t offset, size_t order);
+
+public:
+	BuddyAllocator();
+
+	// arena_size must be a power of two of at least 2^MIN_ORDER
+	void init(size_t arena_size);
+	void clear();
+
+	bool allocate(int block_id, size_t size);
+	bool free(int block_id);
+	bool contains(int block_id) const;
+	bool empty() const;
+
+	size_t block_offset(int block_id) const;
+	size_t arena_size() const;
+	size_t free_bytes() const;
+	size_t largest_free_block() const;
+	size_t used_bytes() const;
+	size_t internal_fragmentation() const;
+
+	void dump(size_t base) const;
+
+	static size_t min_block_size();
+};
+
+#endif
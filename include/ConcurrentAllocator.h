@@ -0,0 +1,128 @@
+#ifndef CONCURRENT_ALLOCATOR_H
+#define CONCURRENT_ALLOCATOR_H
+
+#include "MemoryManager.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Thread-safe allocator in the style of tcmalloc, over a heap of its own.
+// Objects are addresses in the simulated heap.
+//
+// Requests up to MAX_SMALL bytes are rounded up to a size class and served
+// by the calling thread's ThreadCache without any locking. An empty thread
+// cache list takes a batch of objects from the central list of its class,
+// and a list grown past two batches hands one back, so a lock is taken once
+// per batch. Every central list has its own lock. A central list that runs
+// dry carves a span of whole pages out of the heap into objects of its
+// class; spans stay with their class once carved.
+//
+// The heap is a MemoryManager behind one lock, taken only for new spans and
+// for requests above MAX_SMALL, which are page-aligned first fit blocks. A
+// page map records the class of every page, so a free needs only the address.
+class ConcurrentAllocator {
+public:
+	static const size_t PAGE_SIZE = 8192;
+	static const size_t MAX_SMALL = 1024;
+	static const size_t MAX_BATCH = 32;
+	static const size_t NO_ADDRESS = static_cast<size_t>(-1);
+
+	class ThreadCache {
+	private:
+		ConcurrentAllocator& owner;
+		std::vector<std::vector<size_t>> lists;     // per size class
+		size_t hits;
+		size_t misses;
+		size_t fetches;             // batches taken from central lists
+		size_t releases;            // batches handed back
+		size_t merged_hits;         // already added to the owner's totals
+		size_t merged_misses;
+
+	public:
+		explicit ThreadCache(ConcurrentAllocator& owner);
+		ThreadCache(const ThreadCache&) = delete;
+		ThreadCache& operator=(const ThreadCache&) = delete;
+		// Returns all cached objects to the central lists
+		~ThreadCache();
+
+		// NO_ADDRESS if the heap is exhausted
+		size_t allocate(size_t size);
+		// Objects may be freed through any thread's cache
+		void free(size_t address);
+		void flush();
+		// Adds the hits and misses since the last merge to the allocator's
+		// totals; flush does this too
+		void merge_stats();
+
+		// Counts over the cache's lifetime
+		size_t get_hits() const;
+		size_t get_misses() const;
+		size_t get_fetches() const;
+		size_t get_releases() const;
+		size_t cached_objects() const;
+	};
+
+private:
+	struct SizeClass {
+		size_t size;
+		size_t batch;       // objects moved per transfer
+		size_t span_pages;  // pages carved at once, at least one batch
+	};
+
+	// Padded to a cache line so threads working on neighbouring classes
+	// do not share one
+	struct alignas(64) CentralList {
+		std::mutex lock;
+		std::vector<size_t> objects;
+	};
+
+	std::vector<SizeClass> classes;
+	std::vector<uint8_t> class_of_size;     // (size + 7) / 8 -> class
+	std::vector<CentralList> central;
+
+	std::mutex heap_lock;
+	MemoryManager heap;
+	std::unordered_map<size_t, int> large_blocks;   // address -> block id
+
+	// Class + 1 per page; 0 for pages of large blocks or not yet used.
+	// Written under heap_lock before any object on the page is handed out.
+	std::vector<uint8_t> page_class;
+
+	std::atomic<size_t> spans;
+	std::atomic<size_t> large_allocs;
+	std::atomic<size_t> fetches;
+	std::atomic<size_t> releases;
+	std::atomic<size_t> contended;
+	std::atomic<size_t> cache_hits;
+	std::atomic<size_t> cache_misses;
+	std::atomic<size_t> failures;
+
+	std::unique_lock<std::mutex> acquire(std::mutex& m);
+	size_t size_class(size_t size) const;
+	size_t class_of_address(size_t address) const;
+	bool carve_span(size_t cls, std::vector<size_t>& out);
+	size_t fetch_batch(size_t cls, std::vector<size_t>& out);
+	void release_batch(size_t cls, std::vector<size_t>& list, size_t count);
+	size_t allocate_large(size_t size);
+	void free_large(size_t address);
+
+public:
+	explicit ConcurrentAllocator(size_t heap_size);
+
+	size_t num_classes() const;
+	size_t class_size(size_t cls) const;
+
+	// Bytes taken from the heap, spans and large blocks
+	size_t heap_used();
+	// Lock acquisitions that waited for another thread, and requests the
+	// heap could not serve
+	size_t get_contended() const;
+	size_t get_failures() const;
+	void print_stats();
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef FREE_BLOCK_INDEX_H
+#define FREE_BLOCK_INDEX_H
+
+#include "MemoryBlock.h"
+#include "NodePool.h"
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+// Index over the free blocks of a MemoryManager.
+// Free blocks are kept in size-class bins ordered by address (for first fit)
+// and in one tree ordered by (size, address) (for best and worst fit). Each
+// power of two is split into 8 classes so the one bin that may hold blocks
+// smaller than a request stays short. Ties are broken by lowest address,
+// which is the block a full list scan would have picked first.
+// Entries carry their keys inline so tree searches never touch the blocks.
+class FreeBlockIndex {
+private:
+	static const size_t SUB_BITS = 3;
+	static const size_t NUM_CLASSES = 64 << SUB_BITS;
+	static const size_t NUM_WORDS = NUM_CLASSES / 64;
+
+	struct BinEntry {
+		size_t start;
+		size_t size;
+		MemoryBlock* block;
+
+		bool operator<(const BinEntry& other) const {
+			return start < other.start;
+		}
+	};
+
+	struct SizeEntry {
+		size_t size;
+		size_t start;
+		MemoryBlock* block;
+
+		bool operator<(const SizeEntry& other) const {
+			if (size != other.size)
+				return size < other.size;
+			return start < other.start;
+		}
+	};
+
+	typedef std::set<BinEntry, std::less<BinEntry>, PoolAllocator<BinEntry>> BinSet;
+	typedef std::set<SizeEntry, std::less<SizeEntry>, PoolAllocator<SizeEntry>> SizeSet;
+
+	// Tree nodes for every set below; declared first so it outlives them
+	NodePool node_pool;
+
+	std::vector<BinSet> bins;
+	SizeSet by_size;
+	uint64_t nonempty_bins[NUM_WORDS];
+	size_t free_bytes;
+
+	static size_t size_class(size_t size);
+
+public:
+	FreeBlockIndex();
+
+	// Blocks must be erased before their start or size is changed
+	void insert(MemoryBlock* block);
+	void erase(MemoryBlock* block);
+	void clear();
+
+	MemoryBlock* first_fit(size_t size) const;
+	MemoryBlock* best_fit(size_t size) const;
+	MemoryBlock* worst_fit(size_t size) const;
+
+	// Lowest-address block holding size bytes from a multiple of alignment
+	MemoryBlock* aligned_fit(size_t size, size_t alignment) const;
+
+	// Bytes in all indexed blocks, and the size of the largest one (0 if
+	// none), both in O(1)
+	size_t total_bytes() const;
+	size_t largest_size() const;
+};
+
+#endif
@@ -7,6 +7,7 @@ struct MemoryBlock {
 	size_t start;
 	size_t size;
 	bool free;
+	bool pinned;        // allocated aligned; compaction leaves it in place
 	int block_id;
 
 	MemoryBlock* next;
@@ -2,6 +2,23 @@
 #define MEMORY_MANAGER_H
 
 #include "MemoryBlock.h"
+#include "FreeBlockIndex.h"
+#include "BuddyAllocator.h"
+#include "NodePool.h"
+#include "RelocationListener.h"
+
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+struct FragmentationSample {
+	size_t requests;
+	size_t failures;
+	size_t free_bytes;
+	size_t largest_free;
+	size_t used_bytes;
+	double external_fragmentation;
+};
 
 class MemoryManager {
 private:
@@ -10,7 +27,48 @@ private:
 	int next_block_id;
 	size_t alloc_requests;
 	size_t alloc_failures;
+
+	// MemoryBlock nodes and block_index entries are recycled through pools
+	// instead of going through new/delete on every split and coalesce
+	NodePool block_pool;
+	NodePool index_pool;
+
+	// Allocated blocks by id, kept in sync with splitting and coalescing
+	std::unordered_map<int, MemoryBlock*, std::hash<int>, std::equal_to<int>,
+		PoolAllocator<std::pair<const int, MemoryBlock*>>> block_index;
+
+	// Free blocks by size class and by size, kept in sync the same way
+	FreeBlockIndex free_index;
+
+	// Buddy allocations are served from one power-of-two arena carved out
+	// of the block list on first use and returned once it is empty
+	BuddyAllocator buddy;
+	int buddy_arena_id;
+
+	// Every sample_interval-th allocation request appends a sample; 0 is off
+	size_t sample_interval;
+	std::vector<FragmentationSample> samples;
+
+	// Compaction: the listener is not owned. With auto_compact, a request
+	// that fails although enough memory is free runs one compaction step
+	// of compact_step bytes (0 for a full pass) and is retried.
+	RelocationListener* listener;
+	bool auto_compact;
+	size_t compact_step;
+	size_t compaction_steps;
+	size_t bytes_moved;
+	size_t blocks_moved;
+	size_t longest_step;
+
+	MemoryBlock* new_block(size_t start, size_t size);
+	void delete_block(MemoryBlock* block);
 	MemoryBlock* split_and_allocate(MemoryBlock* block, size_t req_size);
+	void coalesce_free(MemoryBlock* block);
+	void release_blocks();
+	bool reserve_buddy_arena();
+	void release_buddy_arena();
+	int finish_request(int block_id);
+	bool compact_for(size_t req_size);
 
 public:
 	MemoryManager();
@@ -22,6 +80,12 @@ public:
 	bool free_block(int block_id);
 	int allocate_best_fit(size_t size);
 	int allocate_worst_fit(size_t size);
+	int allocate_buddy(size_t size);
+	// First fit whose start is a multiple of alignment (a power of two);
+	// the gap in front of it stays free
+	int allocate_aligned(size_t size, size_t alignment);
+	// Fragmentation metrics are O(1): the free block index keeps the free
+	// bytes and the largest free block up to date
 	size_t total_free_memory() const;
 	size_t largest_free_block() const;
 	double external_fragmentation() const;
@@ -33,6 +97,27 @@ public:
 	double allocation_failure_rate() const;
 	size_t internal_fragmentation() const;
 	size_t get_block_start(int block_id) const;
+	size_t used_memory() const;
+
+	// Slides allocated blocks towards address 0, lowest first, closing the
+	// free gaps between them. Block ids stay the same; only their starts
+	// change, and the listener hears of every move. A step stops before
+	// moving more than max_bytes (0 for no limit), but always moves at
+	// least one block if any is out of place, so repeated steps finish the
+	// job. Blocks from allocate_aligned stay in place, and so do the gaps
+	// below them. Returns the bytes moved.
+	size_t compact(size_t max_bytes = 0);
+	void set_auto_compaction(bool on, size_t step_bytes = 0);
+	void set_relocation_listener(RelocationListener* l);
+	RelocationListener* get_relocation_listener() const;
+	size_t get_bytes_moved() const;
+
+	// Samples the fragmentation metrics after every interval-th allocation
+	// request from now on (0 stops); init() drops the samples taken
+	void set_fragmentation_sampling(size_t interval);
+	size_t num_fragmentation_samples() const;
+	void write_fragmentation_csv(std::ostream& out) const;
+	void write_fragmentation_json(std::ostream& out) const;
 
 };
 
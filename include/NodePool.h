@@ -0,0 +1,69 @@
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Free-list pool for fixed-size nodes.
+// Memory is taken from the host heap in chunks and recycled through an
+// intrusive free list, so steady-state allocation never reaches the host
+// allocator. The node size is fixed by the first allocation; larger requests
+// are passed through to operator new.
+class NodePool {
+private:
+	static const size_t NODES_PER_CHUNK = 1024;
+
+	struct FreeNode {
+		FreeNode* next;
+	};
+
+	size_t node_size;
+	std::vector<std::unique_ptr<char[]>> chunks;
+	size_t chunk_used;
+	FreeNode* free_list;
+
+public:
+	NodePool();
+	NodePool(const NodePool&) = delete;
+	NodePool& operator=(const NodePool&) = delete;
+
+	void* allocate(size_t size);
+	void deallocate(void* p, size_t size);
+};
+
+// STL allocator that takes single nodes from a NodePool.
+// Node-based containers (std::set, std::unordered_map) allocate one node at
+// a time, so all of their per-element allocations go through the pool.
+template <typename T>
+struct PoolAllocator {
+	typedef T value_type;
+
+	NodePool* pool;
+
+	explicit PoolAllocator(NodePool* p) : pool(p) {}
+
+	template <typename U>
+	PoolAllocator(const PoolAllocator<U>& other) : pool(other.pool) {}
+
+	T* allocate(size_t n) {
+		if (n == 1)
+			return static_cast<T*>(pool->allocate(sizeof(T)));
+		return std::allocator<T>().allocate(n);
+	}
+
+	void deallocate(T* p, size_t n) {
+		if (n == 1)
+			pool->deallocate(p, sizeof(T));
+		else
+			std::allocator<T>().deallocate(p, n);
+	}
+
+	template <typename U>
+	bool operator==(const PoolAllocator<U>& other) const { return pool == other.pool; }
+
+	template <typename U>
+	bool operator!=(const PoolAllocator<U>& other) const { return pool != other.pool; }
+};
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef RELOCATION_LISTENER_H
+#define RELOCATION_LISTENER_H
+
+#include <cstddef>
+
+// Told by MemoryManager::compact() about every block it moves, right after
+// the move. The block keeps its id, but whatever was at [old_start,
+// old_start + size) is now at new_start.
+class RelocationListener {
+public:
+	virtual ~RelocationListener() {}
+	virtual void on_relocate(int block_id, size_t old_start, size_t new_start, size_t size) = 0;
+};
+
+#endif
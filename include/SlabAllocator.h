@@ -0,0 +1,84 @@
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+#include "MemoryManager.h"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Kernel-style object caches on top of a MemoryManager.
+// Each cache serves one object size from slabs carved out of the heap with
+// allocate_first_fit. Slabs sit on a partial, full or empty list and keep a
+// stack of free object slots, so allocating and freeing an object is O(1).
+//
+// An object id is its slab's number times MAX_OBJECTS_PER_SLAB plus its
+// slot, plus one; the slab table turns it back into the slab, so no record
+// is kept per object. Ids of freed objects are reused with their slots.
+class SlabAllocator {
+private:
+	static const size_t OBJECT_ALIGN = 8;
+	static const size_t MIN_SLAB_SIZE = 512;
+	static const size_t MIN_OBJECTS_PER_SLAB = 8;
+	// 512 / 8; larger objects get slabs of 8 to 15 objects
+	static const size_t MAX_OBJECTS_PER_SLAB = 64;
+
+	struct Slab {
+		int block_id;
+		size_t number;              // index in the slab table
+		size_t in_use;
+		uint64_t allocated;         // bit per slot
+		std::vector<size_t> free_slots;
+		std::vector<size_t> requested;  // bytes asked for, per slot
+	};
+
+	typedef std::list<Slab>::iterator SlabRef;
+
+	struct SlabCache {
+		size_t object_size;
+		size_t slab_size;
+		size_t objects_per_slab;
+		size_t active_objects;
+		size_t requested_bytes;
+
+		std::list<Slab> partial;
+		std::list<Slab> full;
+		std::list<Slab> empty;
+	};
+
+	struct SlabEntry {
+		SlabCache* cache;           // nullptr for a free number
+		SlabRef slab;
+	};
+
+	MemoryManager& mm;
+	std::map<size_t, SlabCache> caches;
+	std::vector<SlabEntry> slabs;
+	std::vector<size_t> free_numbers;
+	std::unordered_map<int, size_t> slab_of_block;  // block id -> number
+
+	const SlabEntry* find_object(int object_id, size_t& slot) const;
+	SlabCache& cache_for(size_t object_size);
+	bool grow(SlabCache& cache);
+
+public:
+	SlabAllocator(MemoryManager& mm);
+
+	int allocate(size_t size);
+	bool free(int object_id);
+	size_t object_address(int object_id) const;
+	// True for the blocks slabs are carved from, which only the slab
+	// allocator may free
+	bool owns_block(int block_id) const;
+
+	// Forget all caches, e.g. after the heap has been re-initialized
+	void reset();
+
+	size_t wasted_bytes() const;
+	void print_stats() const;
+};
+
+#endif
@@ -2,9 +2,22 @@
 #define CACHE_H
 
 #include "cache/CacheSet.h"
+#include "cache/InclusionPolicy.h"
+#include "cache/MemoryLatencyModel.h"
+#include "cache/Prefetcher.h"
+#include "cache/WritePolicy.h"
+#include <cstdint>
 #include <vector>
 #include <string>
 
+struct PrefetchStats {
+    size_t issued;
+    size_t useful;      // hit by a demand access before eviction
+    size_t late;        // useful, but the data had not arrived yet
+    size_t unused;      // evicted without a demand hit
+    size_t polluting;   // evicted a line that then missed
+};
+
 class Cache {
 private:
     size_t cache_size;
@@ -12,34 +25,139 @@ private:
     size_t associativity;
     size_t num_sets;
 
-    std::string replacement_policy;
+    ReplacementPolicy replacement_policy;
+    uint64_t seed;
+    WritePolicy write_policy;
+    WriteMissPolicy write_miss_policy;
+    InclusionPolicy inclusion;
+
+    // Access paths specialized for replacement_policy, chosen at
+    // construction. Both return the cycles spent. A level that hands a
+    // line up out of an exclusive cache reports whether it was dirty.
+    size_t (Cache::*access_fn)(size_t address, AccessType type, bool& dirty);
+    size_t (Cache::*victim_fn)(size_t address, bool dirty);
+
+    template <ReplacementPolicy Policy>
+    size_t access_as(size_t address, AccessType type, bool& dirty);
+
+    // A line evicted from the level above: dirty lines are writebacks,
+    // clean ones victim fills into an exclusive level
+    template <ReplacementPolicy Policy>
+    size_t victim_as(size_t address, bool dirty);
+
+    template <ReplacementPolicy Policy>
+    void issue_prefetches(uint64_t line, PrefetchTrigger trigger);
 
-    std::vector<CacheSet> sets;
+    bool exclusive_of_above() const;
+    size_t fetch(size_t address, AccessType type, bool& dirty);
+    size_t evicted(const CacheVictim& victim, size_t set_index, bool by_prefetch);
+    size_t send_down(size_t address, bool dirty);
+    size_t write_through(size_t address);
+    size_t memory_cycles(size_t address);
+
+    // Drops every line of [address, address + bytes) here and above;
+    // returns true if any of them was dirty
+    bool back_invalidate(size_t address, size_t bytes);
+
+    CacheArrays arrays;
 
     size_t timestamp;
     size_t hits;
     size_t misses;
 
-    size_t hit_time;
-    size_t miss_penalty;
+    size_t reads;
+    size_t writes;
+    size_t writebacks;
+    size_t writeback_bytes;
+    size_t write_throughs;
+    size_t victim_fills;
+    size_t back_invalidations;
+
+    size_t latency;
+    size_t memory_latency;
+    MemoryLatencyModel* memory_model;   // not owned; replaces memory_latency
     size_t total_accesses;
     size_t total_cycles;
 
-    Cache* next_level; 
+    Cache* next_level;
+    std::vector<Cache*> prev_levels;    // private caches share the level below
+
+    // Private caches on a coherence bus remember which chunks of each
+    // line they accessed, to tell false sharing from true sharing
+    bool coherent;
+
+    // Lines recently evicted by prefetches, to spot pollution when
+    // they miss again; entries hold line + 1 so that 0 is empty
+    static const size_t POLLUTION_FILTER_SIZE = 1024;
+
+    Prefetcher* prefetcher;
+    std::vector<uint64_t> prefetch_lines;
+    std::vector<uint64_t> pollution_filter;
+    PrefetchStats prefetch;
 
 public:
+    static const size_t DEFAULT_LATENCY = 1;
+    static const size_t DEFAULT_MEMORY_LATENCY = 10;
+
+    // seed drives the RANDOM policy and BRRIP's occasional near insertions
     Cache(size_t cache_size,
           size_t block_size,
           size_t associativity,
-          const std::string& policy);
+          const std::string& policy,
+          uint64_t seed = 1);
 
+    // Also makes this level one of those above next; nullptr unlinks it
     void set_next_level(Cache* next);
 
-    void access(size_t address);
+    // Attaches a prefetcher (not owned); nullptr detaches it
+    void set_prefetcher(Prefetcher* p);
+    Prefetcher* get_prefetcher() const;
+
+    // Defaults to write-back with write-allocate
+    void set_write_policy(WritePolicy policy, WriteMissPolicy miss_policy);
+
+    // Relation to the level above; defaults to NINE
+    void set_inclusion(InclusionPolicy policy);
+
+    // Cycles for a hit here, and for a miss in the last level to reach memory
+    void set_latency(size_t cycles);
+    void set_memory_latency(size_t cycles);
+    // Asks model for the cost of reaching memory instead; nullptr detaches it
+    void set_memory_model(MemoryLatencyModel* model);
+
+    // Records touched chunks for a CoherenceBus; takes effect on reset()
+    void set_coherent(bool on);
+
+    // Empties the cache and clears its statistics
+    void reset();
+
+    // Returns the cycles the access took, including lower levels
+    size_t access(size_t address, AccessType type = AccessType::READ);
+
+    // Snoops from a CoherenceBus. probe() reports whether the line is held,
+    // whether it is dirty and which of its chunks were touched since it was
+    // filled. Invalidating or downgrading a dirty line writes it back
+    // first; both return the cycles that took.
+    bool probe(size_t address, bool& dirty, uint64_t& touched);
+    size_t snoop_invalidate(size_t address);
+    size_t snoop_downgrade(size_t address);
+
+    // Chunk bit the address falls in, as recorded by a coherent cache
+    uint64_t chunk_of(size_t address) const;
 
     void print_stats(const std::string& name) const;
 
+    size_t get_block_size() const;
+    size_t get_num_sets() const;
+    size_t get_associativity() const;
+    size_t get_latency() const;
+
+    // Average cycles per access arriving at this level
     double amat() const;
+    double hit_rate() const;
+    size_t get_hits() const;
+    size_t get_misses() const;
+    const PrefetchStats& prefetch_stats() const;
 };
 
 #endif
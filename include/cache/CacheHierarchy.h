@@ -0,0 +1,92 @@
+#ifndef CACHE_HIERARCHY_H
+#define CACHE_HIERARCHY_H
+
+#include "cache/Cache.h"
+#include "cache/CoherenceBus.h"
+#include "cache/MemoryLatencyModel.h"
+#include "cache/Prefetcher.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Owns a stack of cache levels, L1 first, in front of DRAM. Every level
+// below L1 follows the same inclusion policy towards the levels above it.
+//
+// With more than one core, each core gets a private copy of L1 and the
+// levels below are shared; a CoherenceBus keeps the copies coherent.
+class CacheHierarchy {
+private:
+    std::vector<std::unique_ptr<Cache>> levels;
+    std::vector<std::string> names;
+
+    // L1s of cores 1 and up; core 0 uses levels[0]. Each has its own
+    // prefetcher like the one attached to levels[0], if any.
+    std::vector<std::unique_ptr<Prefetcher>> core_prefetchers;
+    std::vector<std::unique_ptr<Cache>> core_caches;
+    std::unique_ptr<CoherenceBus> bus;
+
+    InclusionPolicy inclusion;
+    size_t dram_latency;
+    MemoryLatencyModel* memory_model;
+
+    void copy_l1_prefetcher();
+
+public:
+    CacheHierarchy(InclusionPolicy inclusion, size_t dram_latency);
+
+    // Appends a level below the existing ones. Block sizes may not shrink
+    // going down, and must match in an exclusive hierarchy; returns false
+    // if the level cannot be added.
+    bool add_level(const std::string& name,
+                   size_t cache_size,
+                   size_t block_size,
+                   size_t associativity,
+                   const std::string& policy,
+                   size_t latency,
+                   WritePolicy write_policy = WritePolicy::WRITE_BACK,
+                   WriteMissPolicy write_miss_policy = WriteMissPolicy::WRITE_ALLOCATE);
+
+    // Empties every level and switches the inclusion policy. Returns
+    // false for an exclusive hierarchy with private caches per core.
+    bool set_inclusion(InclusionPolicy policy);
+    InclusionPolicy get_inclusion() const;
+
+    // Empties every level and switches the write policies of one level;
+    // for L1 the copies of every core follow
+    void set_write_policy(size_t index, WritePolicy policy, WriteMissPolicy miss_policy);
+
+    // Attaches a prefetcher (not owned) to one level; nullptr detaches it.
+    // For L1 every other core gets a prefetcher of the same kind, degree
+    // and distance, so each core prefetches for its own stream.
+    void set_prefetcher(size_t index, Prefetcher* prefetcher);
+
+    // Empties every level and gives each core its own copy of L1. More
+    // than one core needs a shared level below L1 and a hierarchy that is
+    // not exclusive; returns false otherwise.
+    bool set_cores(size_t cores);
+    size_t num_cores() const;
+
+    // Memory whose latency depends on the address and the core (not
+    // owned), in place of the fixed DRAM latency; nullptr detaches it
+    void set_memory_model(MemoryLatencyModel* model);
+
+    // Returns the cycles the access from core took
+    size_t access(size_t address, AccessType type = AccessType::READ, size_t core = 0);
+
+    // Drops every line of [start, start + size) from every level and core,
+    // writing dirty ones back first, as when memory is moved. Returns the
+    // cycles the writebacks took.
+    size_t invalidate_range(size_t start, size_t size);
+
+    size_t num_levels() const;
+    Cache& level(size_t index);
+
+    // Level index for a name such as "L2", or -1
+    int find_level(const std::string& name) const;
+
+    // Cycles per access seen by the cores, DRAM included
+    double amat() const;
+    void print_stats() const;
+};
+
+#endif
@@ -1,21 +1,107 @@
 #ifndef CACHE_SET_H
 #define CACHE_SET_H
 
-#include "cache/CacheLine.h"
+#include "cache/ReplacementPolicy.h"
+#include <cstddef>
+#include <cstdint>
 #include <vector>
-#include <string>
 
+// Line and replacement state for all sets of a Cache, stored as
+// structure-of-arrays. Per-way arrays hold `stride` consecutive entries per
+// set: the associativity rounded up to the SIMD width, with padding ways
+// never valid. Only the arrays the replacement policy needs are allocated.
+struct CacheArrays {
+    size_t ways;
+    size_t stride;
+
+    std::vector<uint64_t> tags;
+    std::vector<uint64_t> valid;        // one bit per way, one word per set
+    std::vector<uint64_t> dirty;        // same layout as valid
+    std::vector<uint64_t> prefetched;   // prefetched, not used yet; same layout
+    std::vector<uint64_t> prefetch_ready; // per way, only with a prefetcher
+    std::vector<uint64_t> touched;      // per way, only in coherent caches
+    std::vector<uint64_t> last_used;    // LRU, LFU
+    std::vector<uint64_t> inserted_at;  // FIFO
+
+    // PLRU: tree node bits, one word per set. Touching a way sets and
+    // clears the same node bits every time, so both masks are precomputed.
+    std::vector<uint64_t> plru_bits;
+    std::vector<uint64_t> plru_touch_set;
+    std::vector<uint64_t> plru_touch_clear;
+    size_t plru_leaves;
+
+    std::vector<uint64_t> rrpv_masks;   // RRIP: ways per prediction value, 4 words per set
+
+    // LFU: use counts and a per-set min-heap of ways keyed on
+    // (use count, last use)
+    std::vector<uint32_t> use_count;
+    std::vector<uint8_t> heap;
+    std::vector<uint8_t> heap_pos;
+
+    uint64_t rng_state;                 // RANDOM victims, BRRIP insertions
+
+    void init(size_t num_sets, size_t ways, ReplacementPolicy policy, uint64_t seed);
+    uint64_t next_random();
+};
+
+// Line displaced by CacheSet::fill
+struct CacheVictim {
+    uint64_t tag;
+    bool valid;
+    bool dirty;
+    bool prefetched;    // brought in by a prefetch and never used
+};
+
+// View of one set inside a Cache's CacheArrays
 class CacheSet {
 private:
-    std::vector<CacheLine> lines;
+    CacheArrays& arrays;
+    size_t set;
+    size_t base;
+
+    size_t plru_victim() const;
+
+    size_t rrip_victim();
+    void rrip_set(size_t way, unsigned rrpv);
+
+    bool lfu_less(size_t a, size_t b) const;
+    void lfu_sift_down(size_t pos);
+    void lfu_sift_up(size_t pos);
 
 public:
-    CacheSet(size_t associativity);
+    static const size_t SIMD_WAYS = 4;
+    static const size_t MAX_WAYS = 64;
+    static const unsigned RRPV_MAX = 3;
+
+    CacheSet(CacheArrays& arrays, size_t set);
+
+    // Way holding tag, or -1; compares all ways with SIMD where available
+    int find(uint64_t tag) const;
+
+    // Way holding tag, or -1; a hit updates the replacement state
+    template <ReplacementPolicy Policy>
+    int lookup(uint64_t tag, uint64_t timestamp);
+
+    // Installs tag over the policy's victim and returns its way; the line
+    // that was there is described in victim
+    template <ReplacementPolicy Policy>
+    int fill(uint64_t tag, uint64_t timestamp, bool dirty, CacheVictim& victim);
+
+    void mark_dirty(int way);
+    bool is_dirty(int way) const;
+    void clean(int way);
+
+    // Chunks of the line accessed since it was filled, one bit each
+    void touch(int way, uint64_t chunks, bool filled);
+    uint64_t touched(int way) const;
+
+    // Empties a way; the policy's state then treats it like any invalid way
+    void invalidate(int way, ReplacementPolicy policy);
 
-    bool access(size_t tag,
-                const std::string& policy,
-                size_t timestamp,
-                bool& hit);
+    // Prefetched lines remember the cycle their data arrives; the first
+    // demand hit clears the mark and returns true with that cycle
+    void mark_prefetched(int way, uint64_t ready_at);
+    bool take_prefetched(int way, uint64_t& ready_at);
 };
 
 #endif
@@ -0,0 +1,84 @@
+#ifndef COHERENCE_BUS_H
+#define COHERENCE_BUS_H
+
+#include "cache/Cache.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct CoherenceStats {
+    size_t bus_reads;           // BusRd: read misses
+    size_t bus_read_exclusives; // BusRdX: write misses
+    size_t bus_upgrades;        // BusUpgr: writes to Shared lines
+    size_t invalidations;       // copies dropped in other caches
+    size_t interventions;       // Modified copies flushed for a reader
+    size_t coherence_misses;    // misses on lines lost to an invalidation
+    size_t false_sharing;       // invalidations and interventions where
+                                // the cores touched disjoint chunks
+};
+
+// Keeps one private cache per core coherent with snooping MESI. Every
+// access from a core goes through access(), which broadcasts the bus
+// transaction MESI needs to the other cores' caches before the access
+// itself runs in the core's cache.
+//
+// The states are not stored: a line is Modified when dirty, and Shared or
+// Exclusive depending on whether another cache holds it. Read hits and
+// writes to Exclusive or Modified lines stay local. Modified data goes to
+// the shared level below before another core can read it.
+//
+// Contention is counted per line. Once the map outgrows twice the lines the
+// caches can hold, entries for lines that are Invalid in every core are
+// dropped, keeping only the most contended of them for the report; a line
+// dropped after an invalidation no longer counts a coherence miss.
+class CoherenceBus {
+private:
+    struct LineContention {
+        size_t invalidations;
+        size_t interventions;
+        size_t false_sharing;
+        uint64_t cores;         // cores involved in those
+        uint64_t invalidated;   // cores whose next miss is a coherence miss
+    };
+
+    std::vector<Cache*> caches;
+    size_t snoop_latency;
+    size_t block_size;
+
+    CoherenceStats stats;
+    std::unordered_map<uint64_t, LineContention> lines;
+    // Lines no cache holds any more, only the TOP_LINES most contended
+    std::vector<std::pair<uint64_t, LineContention>> retired;
+    size_t sweep_at;            // lines.size() that triggers a sweep
+
+    size_t total_accesses;
+    size_t total_cycles;
+
+    LineContention& contention_of(uint64_t line);
+    void drop_invalid_lines();
+
+public:
+    static const size_t MAX_CORES = 64;
+    static const size_t TOP_LINES = 10;
+
+    // caches[i] belongs to core i and is not owned. Transactions that wait
+    // for other caches to answer cost snoop_latency cycles on top.
+    CoherenceBus(const std::vector<Cache*>& caches, size_t snoop_latency);
+
+    size_t num_cores() const;
+
+    // Returns the cycles the access took, snoops included
+    size_t access(size_t core, size_t address, AccessType type);
+
+    void reset();
+
+    // Cycles per access over all cores
+    double amat() const;
+    const CoherenceStats& get_stats() const;
+
+    // Bus counts and the most contended lines
+    void print_stats() const;
+};
+
+#endif
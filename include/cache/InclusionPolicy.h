@@ -0,0 +1,17 @@
+#ifndef INCLUSION_POLICY_H
+#define INCLUSION_POLICY_H
+
+#include <string>
+
+// How a cache level relates to the levels above it
+enum class InclusionPolicy {
+    INCLUSIVE,  // holds every line above it; evictions back-invalidate
+    EXCLUSIVE,  // victim cache: holds only lines evicted from above
+    NINE        // non-inclusive non-exclusive: fills on misses, no invalidation
+};
+
+// Accepts "inclusive", "exclusive" and "nine"; returns false otherwise
+bool parse_inclusion_policy(const std::string& name, InclusionPolicy& policy);
+const char* inclusion_policy_name(InclusionPolicy policy);
+
+#endif
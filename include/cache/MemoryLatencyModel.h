@@ -0,0 +1,22 @@
+#ifndef MEMORY_LATENCY_MODEL_H
+#define MEMORY_LATENCY_MODEL_H
+
+#include <cstddef>
+
+// Memory behind the last cache level whose latency depends on the address
+// and on the core that asked, such as a NUMA system. A CacheHierarchy
+// names the core before each access; lines that miss the last level, and
+// writebacks from it, then ask the model for their cost in place of the
+// fixed DRAM latency.
+class MemoryLatencyModel {
+public:
+    virtual ~MemoryLatencyModel() {}
+
+    // Core whose accesses follow
+    virtual void set_core(size_t core) = 0;
+
+    // Cycles to read or write back the line at address
+    virtual size_t memory_latency(size_t address) = 0;
+};
+
+#endif
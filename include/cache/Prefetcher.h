@@ -0,0 +1,79 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class PrefetcherType {
+    NEXT_LINE,  // the lines after every miss
+    STRIDE,     // per-region stride detection
+    STREAM      // stream buffers that run ahead of sequential misses
+};
+
+// What the demand access that drives the prefetcher did
+enum class PrefetchTrigger {
+    MISS,
+    HIT,
+    PREFETCH_HIT  // first demand use of a prefetched line
+};
+
+// Returns false for unknown names ("next-line", "stride", "stream")
+bool parse_prefetcher_type(const std::string& name, PrefetcherType& type);
+const char* prefetcher_type_name(PrefetcherType type);
+
+// Hardware prefetcher model attached to a Cache level. It sees the line
+// address of every demand access and proposes lines to prefetch; the cache
+// filters out lines it already holds and inserts the rest through its
+// normal replacement policy.
+//
+// degree is the number of lines proposed per trigger, distance how many
+// lines ahead of the demand stream the first of them is.
+class Prefetcher {
+private:
+    struct StrideEntry {
+        uint64_t region;
+        uint64_t last_line;
+        int64_t stride;
+        unsigned confidence;
+        bool valid;
+    };
+
+    struct Stream {
+        uint64_t head;      // last line prefetched
+        int direction;
+        uint64_t last_used;
+        bool valid;
+    };
+
+    PrefetcherType type;
+    size_t degree;
+    size_t distance;
+
+    std::vector<StrideEntry> stride_table;
+    std::vector<Stream> streams;
+    uint64_t last_miss;
+    uint64_t timestamp;
+
+    void next_line(uint64_t line, PrefetchTrigger trigger, std::vector<uint64_t>& out);
+    void stride(uint64_t line, std::vector<uint64_t>& out);
+    void stream(uint64_t line, PrefetchTrigger trigger, std::vector<uint64_t>& out);
+
+public:
+    static const size_t STRIDE_ENTRIES = 64;
+    static const size_t REGION_LINES = 64;   // 4 KiB regions with 64-byte lines
+    static const unsigned STRIDE_CONFIDENT = 2;
+    static const size_t STREAMS = 8;
+
+    Prefetcher(PrefetcherType type, size_t degree, size_t distance);
+
+    // Appends line addresses to prefetch for a demand access to line
+    void observe(uint64_t line, PrefetchTrigger trigger, std::vector<uint64_t>& out);
+
+    PrefetcherType get_type() const;
+    size_t get_degree() const;
+    size_t get_distance() const;
+};
+
+#endif
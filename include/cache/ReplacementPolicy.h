@@ -0,0 +1,22 @@
+#ifndef REPLACEMENT_POLICY_H
+#define REPLACEMENT_POLICY_H
+
+#include <string>
+
+// Cache line replacement policies. The policy name is resolved once when a
+// cache is built; the per-access code is specialized on the enum value.
+enum class ReplacementPolicy {
+    LRU,
+    FIFO,
+    PLRU,     // tree pseudo-LRU
+    SRRIP,    // static re-reference interval prediction
+    BRRIP,    // bimodal RRIP: most fills predicted distant
+    LFU,      // least frequently used, ties broken by recency
+    RANDOM    // seeded pseudo-random victim
+};
+
+// Returns false for unknown names
+bool parse_replacement_policy(const std::string& name, ReplacementPolicy& policy);
+const char* replacement_policy_name(ReplacementPolicy policy);
+
+#endif
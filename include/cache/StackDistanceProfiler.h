@@ -0,0 +1,80 @@
+#ifndef STACK_DISTANCE_PROFILER_H
+#define STACK_DISTANCE_PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Single-pass LRU stack distance profile (Mattson et al.) of a physical
+// address stream. The stack distance of an access is the number of other
+// lines of its set used since the previous access to its line; an LRU
+// cache with that many sets hits exactly when the distance is below its
+// associativity. One pass therefore gives the miss ratio of every LRU
+// capacity for each profiled set count, with 1 set standing for fully
+// associative caches.
+//
+// Each set keeps a Fenwick tree over its access timestamps with one mark
+// per resident line, at the time of the line's last access; a distance is
+// the number of marks after that time, in O(log n). Timestamps are
+// renumbered when a set's tree fills up.
+class StackDistanceProfiler {
+private:
+    static const uint32_t NO_SLOT = UINT32_MAX;
+
+    struct Stack {
+        std::vector<uint32_t> tree;     // Fenwick tree, 1-based
+        std::vector<uint32_t> owner;    // slot of the line marked at each time
+        uint32_t clock;
+        uint32_t live;
+    };
+
+    struct Geometry {
+        size_t num_sets;
+        std::vector<Stack> sets;
+        std::vector<uint64_t> histogram;    // accesses per stack distance
+        uint64_t cold;                      // first accesses to a line
+    };
+
+    size_t block_size;
+    std::vector<Geometry> geometries;
+
+    // Lines seen so far are numbered by slot; last_time holds, per slot and
+    // geometry, the line's last timestamp in its set plus one
+    std::unordered_map<uint64_t, uint32_t> slots;
+    std::vector<uint32_t> last_time;
+    uint64_t accesses;
+
+    static uint32_t prefix(const Stack& s, uint32_t end);
+    static void add(Stack& s, uint32_t time, int delta);
+    void compact(Stack& s, size_t geometry);
+
+    // Misses of an LRU stack of `ways` lines, from a geometry's histogram
+    static uint64_t misses(const Geometry& g, size_t ways);
+
+public:
+    static const uint32_t MIN_STACK = 64;
+
+    // Profiles each of the given set counts (powers of two or not)
+    StackDistanceProfiler(size_t block_size, const std::vector<size_t>& set_counts);
+
+    void access(size_t address);
+    void reset();
+
+    uint64_t total_accesses() const;
+    size_t distinct_lines() const;
+
+    // Miss ratio of an LRU cache with num_sets sets of ways lines; -1 if
+    // that set count is not profiled
+    double miss_ratio(size_t num_sets, size_t ways) const;
+
+    // Accesses per stack distance, and first accesses, for a profiled set
+    // count; false if that set count is not profiled
+    bool distance_histogram(size_t num_sets, std::vector<uint64_t>& histogram,
+                            uint64_t& cold) const;
+
+    // Miss ratio curves, by capacity, for every profiled set count
+    void print_stats() const;
+};
+
+#endif
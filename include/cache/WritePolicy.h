@@ -0,0 +1,29 @@
+#ifndef WRITE_POLICY_H
+#define WRITE_POLICY_H
+
+#include <string>
+
+enum class AccessType {
+    READ,
+    WRITE
+};
+
+// When a written line reaches the next level: on eviction (write-back, via
+// the dirty bit) or on every store (write-through)
+enum class WritePolicy {
+    WRITE_BACK,
+    WRITE_THROUGH
+};
+
+// Whether a store that misses brings the line into the cache
+enum class WriteMissPolicy {
+    WRITE_ALLOCATE,
+    NO_WRITE_ALLOCATE
+};
+
+// Accept "write-back"/"write-through" and "write-allocate"/"no-write-allocate";
+// return false for unknown names
+bool parse_write_policy(const std::string& name, WritePolicy& policy);
+bool parse_write_miss_policy(const std::string& name, WriteMissPolicy& policy);
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef BINARY_TRACE_H
+#define BINARY_TRACE_H
+
+#include "trace/MappedFile.h"
+#include "trace/TraceRecord.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Compact binary trace format.
+//
+// Header: "MSTR", version byte, flags byte (bit 0: block-compressed).
+// Each record is a tag byte (op in the low nibble, allocation strategy in
+// the high nibble) followed by one LEB128 varint:
+//   - ACCESS / READ / WRITE: zigzag delta from the previous access address
+//   - FREE / SLAB_FREE: zigzag id
+//   - INIT / ALLOC / SLAB_ALLOC: size
+//   - CORE: core id
+//   - CONFIG: text length, then the command text (version 2)
+// In the compressed container the record stream is cut into blocks of about
+// 64 KiB, each stored as varint raw length, varint compressed length and
+// the LZ-compressed bytes; a zero raw length ends the file. Records never
+// straddle blocks.
+struct BinaryTraceFormat {
+    static const uint8_t VERSION = 2;     // reads version 1 as well
+    static const uint8_t FLAG_COMPRESSED = 1;
+    static const size_t HEADER_SIZE = 6;
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    // True if the data starts with the binary trace magic
+    static bool is_binary_trace(const char* data, size_t size);
+    static void write_header(uint8_t* out, bool compressed);
+
+    // Byte-oriented LZ77: (literal count, literals, match length, offset)
+    static void compress_block(const uint8_t* in, size_t n, std::vector<uint8_t>& out);
+    static bool decompress_block(const uint8_t* in, size_t n,
+                                 std::vector<uint8_t>& out, size_t raw_size);
+};
+
+class BinaryTraceWriter {
+private:
+    FILE* out;
+    bool compressed;
+    uint64_t last_address;
+    std::vector<uint8_t> block;
+    std::vector<uint8_t> packed;
+
+    void flush_block();
+
+public:
+    BinaryTraceWriter();
+    ~BinaryTraceWriter();
+
+    bool open(const std::string& path, bool compress);
+    void write(const TraceRecord& record);
+    bool close();
+};
+
+// Streams records out of a binary trace, decompressing one block at a time.
+class BinaryTraceReader {
+private:
+    MappedFile file;
+    bool compressed;
+    const uint8_t* pos;
+    const uint8_t* end;
+    const uint8_t* file_pos;
+    const uint8_t* file_end;
+    std::vector<uint8_t> block;
+    uint64_t last_address;
+    bool corrupt;
+    // CONFIG texts, kept for as long as the reader, since blocks are reused
+    std::deque<std::string> config_text;
+
+    bool load_block();
+
+public:
+    BinaryTraceReader();
+
+    bool open(const std::string& path);
+    bool next(TraceRecord& record);
+
+    bool is_compressed() const { return compressed; }
+    bool is_corrupt() const { return corrupt; }
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file.
+// Uses mmap where available so large traces are paged in on demand instead
+// of being copied through a stream; falls back to reading into a buffer.
+class MappedFile {
+private:
+    const char* data_ptr;
+    size_t length;
+    bool mapped;
+    std::string buffer;
+
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const char* data() const { return data_ptr; }
+    size_t size() const { return length; }
+};
+
+#endif
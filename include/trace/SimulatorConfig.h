@@ -0,0 +1,53 @@
+#ifndef SIMULATOR_CONFIG_H
+#define SIMULATOR_CONFIG_H
+
+#include "cache/CacheHierarchy.h"
+#include "cache/Prefetcher.h"
+#include "vm/NumaTopology.h"
+#include "vm/VirtualMemoryManager.h"
+
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// The commands that configure the caches and the virtual memory rather
+// than issue an operation, such as paging or tlb. Interactive mode runs
+// them as typed; in traces they become CONFIG records, so a replay builds
+// the same simulator the script did.
+class SimulatorConfig {
+private:
+    CacheHierarchy& caches;
+    VirtualMemoryManager& vmm;
+    std::ostream out;
+    std::vector<std::unique_ptr<Prefetcher>> prefetchers;  // per level
+    std::unique_ptr<NumaTopology> numa;
+
+    bool cores(std::istringstream& args);
+    bool inclusion(std::istringstream& args);
+    bool write_policy(std::istringstream& args);
+    bool prefetch(std::istringstream& args);
+    bool vm_policy(std::istringstream& args);
+    bool paging(std::istringstream& args);
+    bool tlb(std::istringstream& args);
+    bool numa_command(std::istringstream& args);
+
+public:
+    // Messages go to messages, e.g. std::cout.rdbuf(); nullptr keeps quiet
+    SimulatorConfig(CacheHierarchy& caches,
+                    VirtualMemoryManager& vmm,
+                    std::streambuf* messages);
+    ~SimulatorConfig();
+    SimulatorConfig(const SimulatorConfig&) = delete;
+    SimulatorConfig& operator=(const SimulatorConfig&) = delete;
+
+    static bool is_command(const std::string& name);
+
+    // Runs one command line. Returns false if the command is unknown or
+    // its arguments are rejected.
+    bool apply(const std::string& line);
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "cache/InclusionPolicy.h"
+#include "cache/WritePolicy.h"
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// One simulator configuration of a sweep
+struct SweepConfig {
+    size_t block_size;
+    size_t l1_size;
+    size_t l1_assoc;
+    std::string l1_policy;
+    size_t l1_latency;
+    std::string l1_prefetcher;      // "none" or a PrefetcherType name
+    size_t l1_prefetch_degree;
+    size_t l1_prefetch_distance;
+    size_t l2_size;
+    size_t l2_assoc;
+    std::string l2_policy;
+    size_t l2_latency;
+    size_t dram_latency;
+    WritePolicy write_policy;           // of both levels
+    WriteMissPolicy write_miss_policy;
+    InclusionPolicy inclusion;
+    size_t cores;
+    size_t vm_memory;
+    std::string vm_policy;
+};
+
+// Cartesian product of parameter values, read from a file with one
+// parameter per line followed by its values:
+//
+//   l1_size 256 512 1024
+//   l1_policy LRU PLRU
+//
+// Parameters that are not listed keep the interactive simulator's values.
+// Blank lines and lines starting with '#' are ignored.
+class SweepGrid {
+private:
+    std::vector<std::vector<std::string>> axes;     // values per parameter
+
+public:
+    static const size_t NUM_PARAMS = 19;
+    static const char* const PARAMS[NUM_PARAMS];
+
+    SweepGrid();
+
+    // Returns false, with a message on stderr, for unknown parameters or
+    // values
+    bool load(const std::string& path);
+
+    size_t size() const;
+
+    // Values of configuration index, in PARAMS order
+    void values(size_t index, std::vector<std::string>& out) const;
+    SweepConfig config(size_t index) const;
+};
+
+struct SweepResult {
+    bool valid;             // false if the hierarchy could not be built
+    size_t records;
+    double l1_hit_rate;     // core 0
+    double l2_hit_rate;
+    double amat;            // global, over all cores
+    size_t page_faults;
+    size_t page_evictions;
+};
+
+// Replays one trace through every configuration of a grid. The trace is
+// decoded once, a chunk at a time; each chunk is fanned out to all
+// configurations on a pool of worker threads, which take configurations
+// from a shared counter so that slow ones do not hold up the rest. The
+// next chunk is decoded while the workers run.
+class SweepRunner {
+private:
+    const SweepGrid& grid;
+    size_t threads;
+
+public:
+    static const size_t CHUNK_RECORDS = 64 * 1024;
+
+    // threads == 0 uses one per hardware thread
+    SweepRunner(const SweepGrid& grid, size_t threads);
+
+    // Returns false if the trace cannot be opened
+    bool run(const std::string& trace_path, std::vector<SweepResult>& results);
+
+    size_t num_threads() const;
+
+    // One row per configuration: the parameters, then the results
+    static void write_csv(std::ostream& out, const SweepGrid& grid,
+                          const std::vector<SweepResult>& results);
+    static void write_json(std::ostream& out, const SweepGrid& grid,
+                           const std::vector<SweepResult>& results);
+};
+
+#endif
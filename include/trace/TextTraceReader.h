@@ -0,0 +1,39 @@
+#ifndef TEXT_TRACE_READER_H
+#define TEXT_TRACE_READER_H
+
+#include "trace/MappedFile.h"
+#include "trace/TraceRecord.h"
+
+#include <string>
+
+// Decodes a text trace (the same commands the interactive mode accepts)
+// into TraceRecords with a hand-written tokenizer over a mapped file.
+// Configuration commands (cores, paging, tlb, ...) become CONFIG records
+// pointing into the mapped file. Commands that only print (dump, stats,
+// ...) are skipped, and commands the replay does not model (compact,
+// profile, ...) are counted as unsupported; "exit" ends the trace.
+class TextTraceReader {
+private:
+    MappedFile file;
+    const char* pos;
+    const char* end;
+    size_t line;
+    size_t skipped;
+    size_t unsupported;
+    size_t malformed;
+
+    bool parse_line(const char* p, const char* eol, TraceRecord& record);
+
+public:
+    TextTraceReader();
+
+    bool open(const std::string& path);
+    bool next(TraceRecord& record);
+
+    size_t lines_read() const { return line; }
+    size_t skipped_lines() const { return skipped; }
+    size_t unsupported_lines() const { return unsupported; }
+    size_t malformed_lines() const { return malformed; }
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef TEXT_TRACE_WRITER_H
+#define TEXT_TRACE_WRITER_H
+
+#include "trace/TraceRecord.h"
+
+#include <cstdio>
+#include <string>
+
+// Writes TraceRecords back out as interactive-mode commands.
+class TextTraceWriter {
+private:
+    FILE* out;
+
+public:
+    TextTraceWriter();
+    ~TextTraceWriter();
+
+    bool open(const std::string& path);
+    void write(const TraceRecord& record);
+    bool close();
+};
+
+#endif
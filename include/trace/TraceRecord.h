@@ -0,0 +1,36 @@
+#ifndef TRACE_RECORD_H
+#define TRACE_RECORD_H
+
+#include <cstdint>
+
+// One simulator operation, decoded from a trace.
+enum class TraceOp : uint8_t {
+    INIT,
+    ALLOC,
+    FREE,
+    ACCESS,
+    SLAB_ALLOC,
+    SLAB_FREE,
+    READ,
+    WRITE,
+    CORE,       // following accesses come from core `value`
+    CONFIG      // a configuration command, see SimulatorConfig
+};
+
+enum class AllocStrategy : uint8_t {
+    FIRST_FIT,
+    BEST_FIT,
+    WORST_FIT,
+    BUDDY
+};
+
+struct TraceRecord {
+    TraceOp op;
+    AllocStrategy strategy; // ALLOC only
+    uint64_t value;         // size, block/object id, virtual address, core
+                            // or CONFIG text length
+    const char* text;       // CONFIG only: the command line, not terminated
+                            // and owned by the reader
+};
+
+#endif
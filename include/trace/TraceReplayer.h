@@ -0,0 +1,45 @@
+#ifndef TRACE_REPLAYER_H
+#define TRACE_REPLAYER_H
+
+#include "trace/TraceRecord.h"
+#include "MemoryManager.h"
+#include "SlabAllocator.h"
+#include "vm/VirtualMemoryManager.h"
+
+class SimulatorConfig;
+
+// Applies decoded trace records to the simulator without per-command
+// output, and keeps aggregate counts for a summary at the end.
+class TraceReplayer {
+private:
+    static const size_t NUM_OPS = 10;
+
+    MemoryManager& mm;
+    SlabAllocator& slab;
+    VirtualMemoryManager& vmm;
+    SimulatorConfig* config;
+
+    bool initialized;
+    size_t op_counts[NUM_OPS];
+    size_t failed_allocs;
+    size_t invalid_frees;
+    size_t invalid_cores;
+    size_t rejected_configs;
+    size_t uninitialized_ops;
+
+public:
+    TraceReplayer(MemoryManager& mm,
+                  SlabAllocator& slab,
+                  VirtualMemoryManager& vmm);
+
+    // Runs CONFIG records (not owned); without one they are rejected
+    void set_config(SimulatorConfig* config);
+
+    void apply(const TraceRecord& record);
+
+    bool is_initialized() const;
+    size_t records() const;
+    void print_summary(double seconds) const;
+};
+
+#endif
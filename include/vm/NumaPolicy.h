@@ -0,0 +1,17 @@
+#ifndef NUMA_POLICY_H
+#define NUMA_POLICY_H
+
+#include <string>
+
+// Node a newly faulted page is placed on
+enum class NumaPolicy {
+    FIRST_TOUCH,    // the node of the core that faults it in
+    INTERLEAVE,     // round robin by page number
+    BIND            // one node only
+};
+
+// Returns false for unknown names ("first-touch", "interleave", "bind")
+bool parse_numa_policy(const std::string& name, NumaPolicy& policy);
+const char* numa_policy_name(NumaPolicy policy);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef NUMA_TOPOLOGY_H
+#define NUMA_TOPOLOGY_H
+
+#include "MemoryManager.h"
+#include "cache/MemoryLatencyModel.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Physical memory split into equal nodes, each with a MemoryManager arena
+// of its own. Node n's arena starts at physical address n * node_size;
+// addresses past the last node, such as the page table region, belong to
+// node 0. Cores are spread over the nodes round robin, so core c sits on
+// node c % nodes.
+//
+// As the memory model of a CacheHierarchy, a line that misses the last
+// level costs the local latency of the node holding it when the core is on
+// that node, and the node's remote latency otherwise. Each node counts its
+// local and remote memory accesses.
+class NumaTopology : public MemoryLatencyModel {
+private:
+    struct Node {
+        std::unique_ptr<MemoryManager> memory;
+        size_t local_latency;
+        size_t remote_latency;
+        size_t local_accesses;
+        size_t remote_accesses;
+    };
+
+    size_t node_size;
+    std::vector<Node> nodes;
+    size_t core_node;
+
+public:
+    static const size_t MAX_NODES = 8;
+
+    // nodes must be between 1 and MAX_NODES
+    NumaTopology(size_t nodes, size_t node_size, size_t local_latency, size_t remote_latency);
+
+    size_t num_nodes() const;
+    size_t get_node_size() const;
+    size_t total_size() const;
+
+    MemoryManager& memory(size_t node);
+    size_t base(size_t node) const;
+    size_t node_of_address(size_t address) const;
+    size_t node_of_core(size_t core) const;
+
+    // Returns false if there is no such node
+    bool set_latency(size_t node, size_t local_latency, size_t remote_latency);
+
+    // Cycles to reach node's memory from a core on node from
+    size_t latency(size_t node, size_t from) const;
+
+    void set_core(size_t core) override;
+    size_t memory_latency(size_t address) override;
+
+    size_t get_local_accesses(size_t node) const;
+    size_t get_remote_accesses(size_t node) const;
+    void reset_stats();
+
+    // One line per node, with the pages resident on it
+    void print_stats(const std::vector<size_t>& resident_pages) const;
+};
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef PAGE_REPLACEMENT_POLICY_H
+#define PAGE_REPLACEMENT_POLICY_H
+
+#include <string>
+
+// Victim selection when every page frame is in use
+enum class PageReplacementPolicy {
+    FIFO,
+    LRU,
+    CLOCK,          // hand sweeps the frames, clearing reference bits
+    SECOND_CHANCE,  // FIFO that requeues referenced pages
+    WSCLOCK,        // CLOCK that keeps pages used within a window
+    OPT             // Belady: evicts the page used furthest in the future
+};
+
+// Returns false for unknown names
+bool parse_page_replacement_policy(const std::string& name, PageReplacementPolicy& policy);
+const char* page_replacement_policy_name(PageReplacementPolicy policy);
+
+#endif
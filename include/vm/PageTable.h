@@ -0,0 +1,122 @@
+#ifndef PAGE_TABLE_H
+#define PAGE_TABLE_H
+
+#include "vm/PageTableEntry.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Radix page table over a va_bits-bit virtual address space. The virtual
+// page number is split into one index per level, all of equal width except
+// the root's, which takes what is left, up to SPLIT_BITS each. Any bits
+// above the levels' reach select one of several roots, created on first
+// use, like a root pointer per region; that choice costs no walk
+// reference. Nodes are created on first use.
+//
+// With huge pages the leaf level is exactly one huge page wide, and the
+// level above holds huge entries next to its child pointers: a valid huge
+// entry maps the whole range of the leaf it replaces, ending walks a level
+// early.
+//
+// Every node has a physical address in a region reserved for page tables
+// above any simulated heap, so the entries a page walk reads can be sent
+// through the cache hierarchy.
+//
+// A node that no longer maps anything is released when its last entry is
+// unmapped and reused, with its physical address, by the next node created
+// at the same level, so the table only grows with the pages resident at once.
+class PageTable {
+private:
+    struct Node {
+        std::vector<uint32_t> children;         // inner levels: node index + 1
+        std::vector<PageTableEntry> entries;    // last level, and huge entries
+        size_t phys_base;
+        size_t live;                            // children, or valid entries
+    };
+
+    size_t levels;
+    size_t page_size;
+    size_t huge_pages;
+    size_t va_bits;
+    size_t offset_bits;
+    size_t index_bits;
+    size_t root_bits;
+    size_t leaf_bits;
+    size_t reach_bits;          // of the vpn, below the root selection
+    size_t next_phys;
+    size_t live_nodes;
+    size_t live_bytes;
+    std::vector<Node> nodes;    // nodes[0] is the root of vpns below the reach
+    std::unordered_map<size_t, uint32_t> roots;     // vpn >> reach_bits -> node
+    std::vector<std::vector<uint32_t>> free_nodes;  // per level
+
+    uint32_t new_node(size_t level);
+    void free_node(uint32_t node, size_t level);
+    size_t index_width(size_t level) const;
+    size_t index_at(size_t vpn, size_t level) const;
+    bool has_huge_entries(size_t level) const;
+    uint32_t parent_of_leaf(size_t vpn);
+    // Root node for vpn; NO_NODE if it does not exist and create is false
+    uint32_t root_of(size_t vpn, bool create);
+
+public:
+    static const size_t DEFAULT_VA_BITS = 48;
+    static const size_t MAX_VA_BITS = 64;
+    static const size_t PTE_SIZE = 8;
+    static const size_t MIN_LEVELS = 2;
+    static const size_t MAX_LEVELS = 4;
+    static const size_t SPLIT_BITS = 12;
+    static const size_t MAX_INDEX_BITS = 16;
+    static const size_t REGION_BASE = (size_t)1 << 40;
+    static const uint32_t NO_NODE = UINT32_MAX;
+
+    // page_size must be a power of two and huge_pages (base pages per huge
+    // page, 1 for none) a power of two; use valid_geometry() first
+    PageTable(size_t levels, size_t page_size, size_t huge_pages = 1,
+              size_t va_bits = DEFAULT_VA_BITS);
+
+    // A huge page may span at most MAX_INDEX_BITS of leaf index, and the
+    // address space must leave every level at least one index bit
+    static bool valid_geometry(size_t levels, size_t page_size, size_t huge_pages = 1,
+                               size_t va_bits = DEFAULT_VA_BITS);
+
+    // Entry for vpn, creating the nodes on its path unless a huge entry
+    // maps it. If walk is not null it receives the physical address of the
+    // entry read at each level, root first; a huge entry's walk is one
+    // level shorter.
+    PageTableEntry& walk(size_t vpn, size_t* walk);
+
+    // Entry for vpn (possibly huge), or nullptr if its leaf node does not
+    // exist
+    PageTableEntry* find(size_t vpn);
+
+    // Marks the entry for vpn valid and returns it for the caller to fill.
+    // References from walk() may be stale after an unmap().
+    PageTableEntry& map(size_t vpn);
+
+    // Clears the entry for vpn and releases the nodes left empty on its path
+    void unmap(size_t vpn);
+
+    // Replaces the leaf holding vpn, whose entries must all be valid, with
+    // one huge entry, which is returned valid for the caller to fill
+    PageTableEntry& promote(size_t vpn);
+
+    // Clears the huge entry mapping vpn and puts back an empty leaf; the
+    // caller maps its pages again
+    void demote(size_t vpn);
+
+    bool in_range(size_t virtual_address) const;
+
+    size_t get_levels() const;
+    size_t get_page_size() const;
+    size_t get_huge_pages() const;
+    size_t get_va_bits() const;
+
+    // Nodes in use and the bytes of their entries
+    size_t num_nodes() const;
+    size_t table_bytes() const;
+};
+
+#endif
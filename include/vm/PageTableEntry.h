@@ -2,15 +2,22 @@
 #define PAGE_TABLE_ENTRY_H
 
 #include <cstddef>
+#include <cstdint>
 
 struct PageTableEntry {
     int block_id;
+    size_t block_offset;    // page's position in its block
+    uint32_t frame;         // VMM frame, or reservation for huge entries
     bool valid;
+    bool huge;              // maps a whole huge page
+    bool referenced;        // set on every access, cleared by the clock hand
+    bool dirty;             // written since loaded or last written back
     size_t loaded_at;
     size_t last_used;
 
     PageTableEntry()
-        : block_id(-1), valid(false),
+        : block_id(-1), block_offset(0), frame(0), valid(false), huge(false),
+          referenced(false), dirty(false),
           loaded_at(0), last_used(0) {}
 };
 
@@ -0,0 +1,50 @@
+#ifndef TLB_H
+#define TLB_H
+
+#include "cache/Cache.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Set-associative translation lookaside buffer with one or two levels.
+// Each level is a Cache over virtual page numbers with one-entry blocks,
+// so it has the same replacement policies and statistics as the data
+// caches. A miss in every level is resolved by the caller's page walk.
+class Tlb {
+private:
+    std::vector<std::unique_ptr<Cache>> levels;
+    std::vector<std::string> names;
+
+    size_t lookups;
+    size_t misses;
+    size_t total_cycles;
+
+public:
+    static const size_t L1_LATENCY = 1;
+    static const size_t L2_LATENCY = 7;
+
+    Tlb();
+
+    // Appends a level of entries translations; returns false if entries
+    // is not a multiple of ways
+    bool add_level(const std::string& name,
+                   size_t entries,
+                   size_t ways,
+                   const std::string& policy,
+                   size_t latency);
+
+    size_t num_levels() const;
+
+    // Looks vpn up, filling it into every level on a miss. Returns true
+    // on a hit; cycles receives the time spent in the TLB.
+    bool lookup(size_t vpn, size_t& cycles);
+
+    // Drops vpn from every level, as when its page is evicted
+    void invalidate(size_t vpn);
+
+    void reset();
+    void print_stats(const std::string& name) const;
+};
+
+#endif
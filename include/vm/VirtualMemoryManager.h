@@ -1,45 +1,263 @@
 #ifndef VIRTUAL_MEMORY_MANAGER_H
 #define VIRTUAL_MEMORY_MANAGER_H
 
-#include "vm/PageTableEntry.h"
+#include "vm/NumaPolicy.h"
+#include "vm/NumaTopology.h"
+#include "vm/PageReplacementPolicy.h"
+#include "vm/PageTable.h"
+#include "vm/Tlb.h"
+#include "vm/WorkingSetTracker.h"
 #include "MemoryManager.h"
-#include "cache/Cache.h"
+#include "RelocationListener.h"
+#include "cache/CacheHierarchy.h"
+#include "cache/StackDistanceProfiler.h"
 
-#include <unordered_map>
-#include <queue>
+#include <memory>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
+
+struct TlbLevelConfig {
+    size_t entries;
+    size_t ways;
+    std::string policy;
+};
 
-class VirtualMemoryManager {
+// Registers itself as the memory manager's relocation listener: pages refer
+// to their backing by block id, so after a compaction only the caches need
+// to drop the moved lines.
+class VirtualMemoryManager : public RelocationListener {
 private:
-    static const size_t PAGE_SIZE = 256;
+    static const size_t DEFAULT_LEVELS = 2;
+    static const size_t DEFAULT_PAGE_SIZE = 256;
+    static const uint32_t NO_FRAME = UINT32_MAX;
+    static const uint32_t NO_RESERVATION = UINT32_MAX;
+    static const size_t NEVER = SIZE_MAX;
+    static const size_t DEFAULT_WSCLOCK_WINDOW = 1024;
+
+    // A physical frame holding one resident page. Frames stay allocated
+    // once taken; eviction hands the frame to the faulting page, with its
+    // backing unless the page goes into a huge page reservation.
+    struct Frame {
+        size_t vpn;
+        int block_id;
+        size_t block_offset;
+        uint32_t reservation;   // NO_RESERVATION if the block is the frame's own
+        uint32_t node;          // NUMA node of the backing, 0 without NUMA
+        uint32_t remote_node;   // node of the recent remote accesses
+        uint32_t remote_accesses;
+        uint32_t prev;
+        uint32_t next;
+        size_t next_use;    // OPT: access index of the page's next use
+    };
 
     MemoryManager& phys_mem;
-    Cache& cache;
+    CacheHierarchy& caches;
 
+    size_t total_memory;
+    size_t page_size;
     size_t max_frames;
     size_t used_frames;
     size_t timestamp;
+    size_t core;
+
+    PageReplacementPolicy policy;
+    size_t wsclock_window;
+    bool verbose;
+
+    StackDistanceProfiler* profiler;
+    WorkingSetTracker* working_set;
 
-    std::string replacement_policy;
+    PageTable page_table;
 
-    std::unordered_map<size_t, PageTableEntry> page_table;
-    std::queue<size_t> fifo_queue;
+    // Resident frames in eviction order: oldest loaded for FIFO and
+    // SECOND_CHANCE, least recently used for LRU, which moves a frame to
+    // the back on every hit. CLOCK and WSCLOCK sweep frames by index.
+    std::vector<Frame> frames;
+    uint32_t oldest;
+    uint32_t newest;
+    uint32_t clock_hand;
 
-    int allocate_frame();
-    int evict_page();
+    // OPT: the loaded trace's access addresses, the next use of each at
+    // the current page size, and resident frames ordered by their next use.
+    // future_pos counts every access since set_future, so it stays in step
+    // with the trace when frames are released.
+    std::vector<size_t> future;
+    std::vector<size_t> next_use;
+    size_t future_pos;
+    std::set<std::pair<size_t, uint32_t>> opt_order;
+
+    // Huge pages: the first fault in an aligned run of huge_pages pages
+    // reserves an aligned block for all of them. Each page faulted in takes
+    // its slot, and a full reservation is promoted to one huge entry.
+    // Reservations are only made while their empty slots, together with the
+    // resident pages, fit in memory.
+    struct Reservation {
+        size_t base_vpn;
+        int block_id;               // -1 when the reservation is unused
+        uint32_t node;
+        size_t populated;
+        bool broken;                // a slot went to a page of another run
+        bool promoted;
+        std::vector<uint32_t> slot_frames;
+    };
+    std::vector<Reservation> reservations;
+    std::vector<uint32_t> free_reservations;
+    std::unordered_map<size_t, uint32_t> reservation_of;    // by run, intact only
+    size_t unpopulated_slots;
+    uint32_t spare_hand;        // next reservation to preempt
+
+    // Address translation is free until paging or a TLB is configured;
+    // after that every TLB miss walks the page table through the caches
+    bool model_translation;
+    std::vector<TlbLevelConfig> tlb_config;
+    std::vector<std::unique_ptr<Tlb>> tlbs;     // per core, built on first use
+
+    // With a NUMA topology (not owned), pages are backed by the arenas of
+    // its nodes instead of phys_mem, placed by numa_policy. With
+    // migrate_after set, a page that many accesses in a row from one
+    // remote node moves to that node.
+    NumaTopology* numa;
+    NumaPolicy numa_policy;
+    uint32_t bind_node;
+    size_t migrate_after;
+
+    uint32_t new_frame();
+    uint32_t take_frame(size_t vpn);
+    uint32_t evict_page();
+    uint32_t select_victim();
+    uint32_t clock_victim();
+    uint32_t second_chance_victim();
+    uint32_t wsclock_victim();
+    void unlink(uint32_t frame);
+    void push_newest(uint32_t frame);
+    void set_next_use(uint32_t frame, size_t next);
+    void compute_next_use();
+    void release_frames();
+
+    uint32_t reserve(size_t vpn, bool create);
+    void release_backing(const Frame& frame);
+    void break_reservation(uint32_t reservation);
+    void bind_slot(uint32_t frame, uint32_t reservation, size_t slot);
+    uint32_t preempt_reservation(size_t& slot);
+    void promote(uint32_t reservation);
+    void demote(uint32_t reservation);
+    size_t huge_key(size_t vpn) const;
+    size_t memory_size() const;
+    MemoryManager& memory(uint32_t node);
+    size_t phys_address(uint32_t node, int block_id, size_t offset);
+    uint32_t place(size_t vpn) const;
+    int allocate_page(uint32_t& node);
+    void rehome(uint32_t frame, uint32_t node);
+    void count_remote(uint32_t frame, PageTableEntry& pte);
+    Tlb* core_tlb();
+    PageTableEntry& translate(size_t vpn);
+    void reset_stats();
 
 public:
+    // Unknown policy names fall back to LRU
     VirtualMemoryManager(MemoryManager& mm,
-                         Cache& l1,
+                         CacheHierarchy& caches,
                          size_t total_memory,
                          const std::string& policy);
+    ~VirtualMemoryManager();
+
+    void on_relocate(int block_id, size_t old_start, size_t new_start, size_t size) override;
 
-    void access(size_t virtual_address);
+    void access(size_t virtual_address, AccessType type = AccessType::READ);
     void print_stats() const;
+    // Physical memory for pages, as given to the constructor
+    size_t get_total_memory() const;
+    size_t get_page_faults() const;
+    size_t get_page_evictions() const;
+    size_t get_page_writebacks() const;
+    size_t get_page_walks() const;
+    double average_translation_time() const;
+    size_t get_promotions() const;
+    size_t get_demotions() const;
+    // Bytes of huge page reservations not backing a page
+    size_t reserved_unpopulated_bytes() const;
+
+    // Per-fault messages; on by default, off for batch replay
+    void set_verbose(bool on);
+
+    // Core issuing the following accesses. Cores run threads of one
+    // process, so they share the page table but not their L1 caches.
+    // Returns false if the cache hierarchy has no such core.
+    bool set_core(size_t core);
+    size_t get_core() const;
+
+    // Sees every physical address sent to the caches (not owned);
+    // nullptr detaches it
+    void set_profiler(StackDistanceProfiler* p);
+
+    // Sees every in-range page reference and whether it faulted (not
+    // owned); nullptr detaches it
+    void set_working_set_tracker(WorkingSetTracker* tracker);
+
+    // Rebuilds the page table with the given depth and page size, huge
+    // pages of huge_page_size bytes unless it is 0, and va_bits-bit virtual
+    // addresses. Every resident page is released and the statistics are
+    // cleared. Returns false for an unsupported geometry or pages larger
+    // than memory.
+    bool set_paging(size_t levels, size_t page_size, size_t huge_page_size = 0,
+                    size_t va_bits = PageTable::DEFAULT_VA_BITS);
+
+    // Switches the page replacement policy. Every resident page is
+    // released and the statistics are cleared.
+    void set_policy(PageReplacementPolicy policy);
+    PageReplacementPolicy get_policy() const;
+
+    // WSCLOCK keeps pages used within the last window accesses
+    void set_wsclock_window(size_t window);
+
+    // OPT needs the virtual addresses of the accesses to come, in order.
+    // Computes each access's next use of the same page in one backward
+    // pass; access() then consumes them one by one. Past the end of the
+    // future every page counts as never used again. set_paging recomputes
+    // the next uses for the new page size.
+    void set_future(const std::vector<size_t>& virtual_addresses);
+
+    // Gives every core a TLB with one level per entry of levels; an empty
+    // vector removes the TLBs. Returns false if a level is invalid.
+    bool set_tlb(const std::vector<TlbLevelConfig>& levels);
+
+    // Backs pages with the nodes of numa (not owned) instead of the
+    // memory manager; nullptr goes back to it. Every resident page is
+    // released and the statistics are cleared. Returns false if a node
+    // cannot hold a page.
+    bool set_numa(NumaTopology* numa);
+    // Placement of the pages faulted in from now on; bind_node is used by
+    // BIND only. Returns false without a topology or for no such node.
+    bool set_numa_policy(NumaPolicy policy, size_t bind_node = 0);
+    // Migrates a page after threshold accesses in a row from one remote
+    // node; 0 turns migration off
+    void set_numa_migration(size_t threshold);
+    size_t get_migrations() const;
 
 private:
     size_t page_faults;
     size_t page_evictions;
+    size_t page_writebacks;
+
+    size_t translations;
+    size_t walks;
+    size_t walk_references;
+    size_t walk_cycles;
+    size_t translation_cycles;
+    size_t out_of_range;
+
+    size_t promotions;
+    size_t demotions;
+    size_t failed_reservations;
+
+    size_t relocations;
+    size_t relocation_cycles;
+
+    size_t migrations;
+    size_t failed_migrations;
+    size_t migration_cycles;
 };
 
 #endif
@@ -0,0 +1,91 @@
+#ifndef WORKING_SET_TRACKER_H
+#define WORKING_SET_TRACKER_H
+
+#include "cache/StackDistanceProfiler.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <vector>
+
+// Time series of a virtual page reference stream, sampled every interval
+// accesses: the working set size W(t, tau) for each tracked window tau,
+// and the page fault rate and resident pages over the interval. Time is
+// counted in accesses.
+//
+// Working sets are estimated with a sliding-window HyperLogLog. Each
+// register keeps only the (time, rank) pairs that can still be its
+// maximum for some window, newest last, so their ranks decrease towards
+// the back; memory is bounded by the register count times the logarithm
+// of the largest window, however many pages are touched. The estimate is
+// within a few percent, and exact in practice for sets much smaller than
+// the register count.
+//
+// The page reuse distance histogram, the number of distinct pages used
+// between two uses of a page, is exact: it is the fully associative stack
+// distance profile at page granularity, and needs a slot per page ever
+// touched. An LRU memory of n pages faults on exactly the accesses at
+// distance n or more. Distances are reported in power-of-two buckets.
+class WorkingSetTracker {
+private:
+    struct Mark {
+        uint64_t time;
+        uint8_t rank;
+    };
+
+    struct Sample {
+        uint64_t time;
+        uint64_t accesses;
+        uint64_t faults;
+        size_t resident;
+        std::vector<double> working_sets;   // one per window
+    };
+
+    std::vector<size_t> windows;        // ascending
+    size_t interval;
+    std::vector<std::deque<Mark>> registers;
+
+    StackDistanceProfiler reuse;
+
+    uint64_t time;
+    uint64_t interval_faults;
+    uint64_t total_faults;
+    std::vector<Sample> samples;
+
+    void take_sample(size_t resident);
+
+public:
+    static const size_t REGISTER_BITS = 10;
+    static const size_t DEFAULT_INTERVAL = 10000;
+
+    // Windows of zero are dropped; without any, a single window of one
+    // interval is tracked
+    WorkingSetTracker(const std::vector<size_t>& windows, size_t interval);
+
+    // One access to vpn, which faulted or not, with resident pages after it
+    void record(size_t vpn, bool fault, size_t resident);
+    void reset();
+
+    // Estimated distinct pages among the last window accesses; window is
+    // capped at the largest tracked one
+    double working_set(size_t window) const;
+
+    const std::vector<size_t>& get_windows() const;
+    size_t get_interval() const;
+    uint64_t total_accesses() const;
+    size_t num_samples() const;
+
+    // Accesses per reuse distance bucket: bucket 0 holds distance 0 and
+    // bucket b distances [2^(b-1), 2^b). cold receives first uses.
+    void reuse_buckets(std::vector<uint64_t>& buckets, uint64_t& cold) const;
+
+    void print_stats() const;
+
+    // The time series, one row per sample
+    void write_csv(std::ostream& out) const;
+    // The time series and the reuse distance histogram
+    void write_json(std::ostream& out) const;
+};
+
+#endif
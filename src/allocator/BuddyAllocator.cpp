@@ -0,0 +1,186 @@
+#include "BuddyAllocator.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+BuddyAllocator::BuddyAllocator()
+    : max_order(0),
+      nonempty_orders(0),
+      allocated_bytes(0),
+      requested_bytes(0) {}
+
+size_t BuddyAllocator::min_block_size() {
+    return (size_t)1 << MIN_ORDER;
+}
+
+size_t BuddyAllocator::order_for(size_t size) {
+    size_t order = MIN_ORDER;
+    while (order < MAX_ORDER && ((size_t)1 << order) < size)
+        order++;
+    return order;
+}
+
+void BuddyAllocator::init(size_t arena_size) {
+    clear();
+    max_order = order_for(arena_size);
+
+    free_lists.assign(max_order + 1, std::set<size_t>());
+    free_bitmaps.assign(max_order + 1, std::vector<uint64_t>());
+    for (size_t order = MIN_ORDER; order <= max_order; ++order) {
+        size_t blocks = (size_t)1 << (max_order - order);
+        free_bitmaps[order].assign((blocks + 63) / 64, 0);
+    }
+
+    push_free(0, max_order);
+}
+
+void BuddyAllocator::clear() {
+    max_order = 0;
+    free_lists.clear();
+    free_bitmaps.clear();
+    nonempty_orders = 0;
+    allocations.clear();
+    allocated_bytes = 0;
+    requested_bytes = 0;
+}
+
+bool BuddyAllocator::is_free(size_t offset, size_t order) const {
+    size_t index = offset >> order;
+    return (free_bitmaps[order][index / 64] >> (index % 64)) & 1;
+}
+
+void BuddyAllocator::push_free(size_t offset, size_t order) {
+    size_t index = offset >> order;
+    free_bitmaps[order][index / 64] |= (uint64_t)1 << (index % 64);
+    free_lists[order].insert(offset);
+    nonempty_orders |= (uint64_t)1 << order;
+}
+
+void BuddyAllocator::remove_free(size_t offset, size_t order) {
+    size_t index = offset >> order;
+    free_bitmaps[order][index / 64] &= ~((uint64_t)1 << (index % 64));
+    free_lists[order].erase(offset);
+    if (free_lists[order].empty())
+        nonempty_orders &= ~((uint64_t)1 << order);
+}
+
+bool BuddyAllocator::allocate(int block_id, size_t size) {
+    // Larger than the arena: no order can hold it
+    if (free_lists.empty() || size > ((size_t)1 << max_order))
+        return false;
+    size_t order = order_for(size);
+
+    // Smallest order with a free block
+    uint64_t candidates = nonempty_orders & ~(((uint64_t)1 << order) - 1);
+    if (!candidates)
+        return false;
+    size_t current = __builtin_ctzll(candidates);
+
+    size_t offset = *free_lists[current].begin();
+    remove_free(offset, current);
+
+    // Split down, keeping the lower half and freeing the upper buddy
+    while (current > order) {
+        current--;
+        push_free(offset + ((size_t)1 << current), current);
+    }
+
+    allocations[block_id] = {offset, order, size};
+    allocated_bytes += (size_t)1 << order;
+    requested_bytes += size;
+    return true;
+}
+
+bool BuddyAllocator::free(int block_id) {
+    auto it = allocations.find(block_id);
+    if (it == allocations.end())
+        return false;
+
+    size_t offset = it->second.offset;
+    size_t order = it->second.order;
+    allocated_bytes -= (size_t)1 << order;
+    requested_bytes -= it->second.requested;
+    allocations.erase(it);
+
+    // Merge with the buddy for as long as it is free
+    while (order < max_order) {
+        size_t buddy = offset ^ ((size_t)1 << order);
+        if (!is_free(buddy, order))
+            break;
+        remove_free(buddy, order);
+        offset = std::min(offset, buddy);
+        order++;
+    }
+
+    push_free(offset, order);
+    return true;
+}
+
+bool BuddyAllocator::contains(int block_id) const {
+    return allocations.count(block_id) != 0;
+}
+
+bool BuddyAllocator::empty() const {
+    return allocations.empty();
+}
+
+size_t BuddyAllocator::block_offset(int block_id) const {
+    auto it = allocations.find(block_id);
+    if (it == allocations.end())
+        return static_cast<size_t>(-1);
+    return it->second.offset;
+}
+
+size_t BuddyAllocator::arena_size() const {
+    return free_lists.empty() ? 0 : (size_t)1 << max_order;
+}
+
+size_t BuddyAllocator::free_bytes() const {
+    return arena_size() - allocated_bytes;
+}
+
+size_t BuddyAllocator::largest_free_block() const {
+    if (!nonempty_orders)
+        return 0;
+    return (size_t)1 << (63 - __builtin_clzll(nonempty_orders));
+}
+
+size_t BuddyAllocator::used_bytes() const {
+    return allocated_bytes;
+}
+
+size_t BuddyAllocator::internal_fragmentation() const {
+    return allocated_bytes - requested_bytes;
+}
+
+void BuddyAllocator::dump(size_t base) const {
+    struct Entry {
+        size_t offset;
+        size_t size;
+        int block_id;
+    };
+    std::vector<Entry> entries;
+
+    for (size_t order = MIN_ORDER; order < free_lists.size(); ++order)
+        for (size_t offset : free_lists[order])
+            entries.push_back({offset, (size_t)1 << order, -1});
+    for (const auto& entry : allocations)
+        entries.push_back({entry.second.offset,
+                           (size_t)1 << entry.second.order, entry.first});
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.offset < b.offset; });
+
+    for (const Entry& e : entries) {
+        std::cout << "    [0x" << std::hex << std::setw(4) << std::setfill('0') << base + e.offset << " - 0x"
+                  << std::setw(4) << (base + e.offset + e.size - 1) << "] ";
+
+        if (e.block_id == -1)
+            std::cout << "FREE\n";
+        else
+            std::cout << "USED (id=" << e.block_id << ", requested=" << std::dec
+                      << allocations.at(e.block_id).requested << std::hex << ")\n";
+    }
+
+    std::cout << std::dec;
+}
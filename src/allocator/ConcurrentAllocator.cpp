@@ -0,0 +1,283 @@
+#include "ConcurrentAllocator.h"
+#include <algorithm>
+#include <iostream>
+
+ConcurrentAllocator::ConcurrentAllocator(size_t heap_size)
+    : page_class(heap_size / PAGE_SIZE + 1, 0),
+      spans(0),
+      large_allocs(0),
+      fetches(0),
+      releases(0),
+      contended(0),
+      cache_hits(0),
+      cache_misses(0),
+      failures(0) {
+
+    // 16-byte steps up to 128, then four classes per doubling
+    std::vector<size_t> sizes = {8};
+    for (size_t size = 16; size <= 128; size += 16)
+        sizes.push_back(size);
+    for (size_t base = 128; base < MAX_SMALL; base *= 2) {
+        for (size_t step = 1; step <= 4; ++step)
+            sizes.push_back(base + base / 4 * step);
+    }
+
+    for (size_t size : sizes) {
+        SizeClass c;
+        c.size = size;
+        // About 64 KB per transfer, as tcmalloc moves
+        c.batch = std::max<size_t>(2, std::min((size_t)MAX_BATCH, 65536 / size));
+        c.span_pages = (c.batch * size + PAGE_SIZE - 1) / PAGE_SIZE;
+        classes.push_back(c);
+    }
+
+    class_of_size.resize(MAX_SMALL / 8 + 1);
+    size_t cls = 0;
+    for (size_t i = 0; i < class_of_size.size(); ++i) {
+        while (classes[cls].size < i * 8)
+            cls++;
+        class_of_size[i] = (uint8_t)cls;
+    }
+
+    central = std::vector<CentralList>(classes.size());
+    heap.init(heap_size);
+}
+
+// Counts the acquisitions that had to wait for another thread
+std::unique_lock<std::mutex> ConcurrentAllocator::acquire(std::mutex& m) {
+    std::unique_lock<std::mutex> lock(m, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        contended++;
+        lock.lock();
+    }
+    return lock;
+}
+
+size_t ConcurrentAllocator::size_class(size_t size) const {
+    return class_of_size[(size + 7) / 8];
+}
+
+size_t ConcurrentAllocator::class_of_address(size_t address) const {
+    return page_class[address / PAGE_SIZE];
+}
+
+bool ConcurrentAllocator::carve_span(size_t cls, std::vector<size_t>& out) {
+    const SizeClass& c = classes[cls];
+    size_t bytes = c.span_pages * PAGE_SIZE;
+
+    size_t start;
+    {
+        std::unique_lock<std::mutex> lock = acquire(heap_lock);
+        int id = heap.allocate_aligned(bytes, PAGE_SIZE);
+        if (id == -1)
+            return false;
+        start = heap.get_block_start(id);
+        for (size_t page = 0; page < c.span_pages; ++page)
+            page_class[start / PAGE_SIZE + page] = (uint8_t)(cls + 1);
+    }
+    spans++;
+
+    // Lowest addresses last, so they are handed out first
+    for (size_t n = bytes / c.size; n > 0; --n)
+        out.push_back(start + (n - 1) * c.size);
+    return true;
+}
+
+// Moves up to one batch from the central list to out; returns the count
+size_t ConcurrentAllocator::fetch_batch(size_t cls, std::vector<size_t>& out) {
+    CentralList& list = central[cls];
+    size_t batch = classes[cls].batch;
+    fetches++;
+
+    std::unique_lock<std::mutex> lock = acquire(list.lock);
+    // Carve outside the class lock; other threads may refill it meanwhile
+    if (list.objects.empty()) {
+        lock.unlock();
+        std::vector<size_t> carved;
+        if (!carve_span(cls, carved))
+            return 0;
+        lock.lock();
+        list.objects.insert(list.objects.end(), carved.begin(), carved.end());
+    }
+
+    size_t n = std::min(batch, list.objects.size());
+    out.insert(out.end(), list.objects.end() - n, list.objects.end());
+    list.objects.resize(list.objects.size() - n);
+    return n;
+}
+
+// Moves the last count objects of a thread cache list to the central list
+void ConcurrentAllocator::release_batch(size_t cls, std::vector<size_t>& objects, size_t count) {
+    CentralList& list = central[cls];
+    releases++;
+
+    std::unique_lock<std::mutex> lock = acquire(list.lock);
+    list.objects.insert(list.objects.end(), objects.end() - count, objects.end());
+    lock.unlock();
+    objects.resize(objects.size() - count);
+}
+
+size_t ConcurrentAllocator::allocate_large(size_t size) {
+    size_t bytes = (size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    std::unique_lock<std::mutex> lock = acquire(heap_lock);
+    int id = heap.allocate_aligned(bytes, PAGE_SIZE);
+    if (id == -1)
+        return NO_ADDRESS;
+
+    size_t start = heap.get_block_start(id);
+    for (size_t page = 0; page < bytes / PAGE_SIZE; ++page)
+        page_class[start / PAGE_SIZE + page] = 0;
+    large_blocks[start] = id;
+    large_allocs++;
+    return start;
+}
+
+void ConcurrentAllocator::free_large(size_t address) {
+    std::unique_lock<std::mutex> lock = acquire(heap_lock);
+    auto it = large_blocks.find(address);
+    if (it == large_blocks.end()) {
+        std::cerr << "free of unknown address " << address << "\n";
+        return;
+    }
+    heap.free_block(it->second);
+    large_blocks.erase(it);
+}
+
+size_t ConcurrentAllocator::num_classes() const {
+    return classes.size();
+}
+
+size_t ConcurrentAllocator::class_size(size_t cls) const {
+    return classes[cls].size;
+}
+
+size_t ConcurrentAllocator::get_contended() const {
+    return contended;
+}
+
+size_t ConcurrentAllocator::get_failures() const {
+    return failures;
+}
+
+size_t ConcurrentAllocator::heap_used() {
+    std::unique_lock<std::mutex> lock = acquire(heap_lock);
+    return heap.used_memory();
+}
+
+void ConcurrentAllocator::print_stats() {
+    size_t central_objects = 0;
+    for (CentralList& list : central) {
+        std::unique_lock<std::mutex> lock = acquire(list.lock);
+        central_objects += list.objects.size();
+    }
+    size_t hits = cache_hits, misses = cache_misses;
+
+    std::cout << "--- Concurrent Allocator Stats ---\n";
+    std::cout << "Size classes: " << classes.size() << " (8-" << MAX_SMALL << " bytes), spans: "
+              << spans << ", large blocks: " << large_allocs << "\n";
+    std::cout << "Thread cache hits: " << hits << ", misses: " << misses;
+    if (hits + misses)
+        std::cout << " (hit rate " << (double)hits / (hits + misses) << ")";
+    std::cout << "\n";
+    std::cout << "Batch transfers: " << fetches << " fetched, " << releases << " released, "
+              << central_objects << " objects in central lists\n";
+    std::cout << "Contended lock acquisitions: " << contended << ", failed requests: "
+              << failures << "\n";
+    std::cout << "Heap used: " << heap_used() << " bytes\n";
+}
+
+ConcurrentAllocator::ThreadCache::ThreadCache(ConcurrentAllocator& a)
+    : owner(a),
+      lists(a.classes.size()),
+      hits(0),
+      misses(0),
+      fetches(0),
+      releases(0),
+      merged_hits(0),
+      merged_misses(0) {}
+
+ConcurrentAllocator::ThreadCache::~ThreadCache() {
+    flush();
+}
+
+size_t ConcurrentAllocator::ThreadCache::allocate(size_t size) {
+    if (size > MAX_SMALL) {
+        size_t address = owner.allocate_large(size);
+        if (address == NO_ADDRESS)
+            owner.failures++;
+        return address;
+    }
+
+    size_t cls = owner.size_class(size ? size : 1);
+    std::vector<size_t>& list = lists[cls];
+    if (list.empty()) {
+        misses++;
+        fetches++;
+        if (!owner.fetch_batch(cls, list)) {
+            owner.failures++;
+            return NO_ADDRESS;
+        }
+    } else {
+        hits++;
+    }
+
+    size_t address = list.back();
+    list.pop_back();
+    return address;
+}
+
+void ConcurrentAllocator::ThreadCache::free(size_t address) {
+    size_t cls = owner.class_of_address(address);
+    if (cls == 0) {
+        owner.free_large(address);
+        return;
+    }
+
+    std::vector<size_t>& list = lists[cls - 1];
+    list.push_back(address);
+    size_t batch = owner.classes[cls - 1].batch;
+    if (list.size() > 2 * batch) {
+        owner.release_batch(cls - 1, list, batch);
+        releases++;
+    }
+}
+
+void ConcurrentAllocator::ThreadCache::flush() {
+    for (size_t cls = 0; cls < lists.size(); ++cls) {
+        if (!lists[cls].empty()) {
+            owner.release_batch(cls, lists[cls], lists[cls].size());
+            releases++;
+        }
+    }
+    merge_stats();
+}
+
+void ConcurrentAllocator::ThreadCache::merge_stats() {
+    owner.cache_hits += hits - merged_hits;
+    owner.cache_misses += misses - merged_misses;
+    merged_hits = hits;
+    merged_misses = misses;
+}
+
+size_t ConcurrentAllocator::ThreadCache::get_hits() const {
+    return hits;
+}
+
+size_t ConcurrentAllocator::ThreadCache::get_misses() const {
+    return misses;
+}
+
+size_t ConcurrentAllocator::ThreadCache::get_fetches() const {
+    return fetches;
+}
+
+size_t ConcurrentAllocator::ThreadCache::get_releases() const {
+    return releases;
+}
+
+size_t ConcurrentAllocator::ThreadCache::cached_objects() const {
+    size_t total = 0;
+    for (const std::vector<size_t>& list : lists)
+        total += list.size();
+    return total;
+}
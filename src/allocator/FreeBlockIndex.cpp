@@ -0,0 +1,128 @@
+#include "FreeBlockIndex.h"
+
+FreeBlockIndex::FreeBlockIndex()
+    : by_size(std::less<SizeEntry>(), PoolAllocator<SizeEntry>(&node_pool)),
+      nonempty_bins(),
+      free_bytes(0) {
+
+    bins.reserve(NUM_CLASSES);
+    for (size_t cls = 0; cls < NUM_CLASSES; ++cls)
+        bins.emplace_back(std::less<BinEntry>(), PoolAllocator<BinEntry>(&node_pool));
+}
+
+size_t FreeBlockIndex::size_class(size_t size) {
+    // Small sizes get a class each
+    if (size < ((size_t)1 << SUB_BITS))
+        return size;
+
+    size_t log2 = 63 - __builtin_clzll(size);
+    size_t sub = (size >> (log2 - SUB_BITS)) & (((size_t)1 << SUB_BITS) - 1);
+    return (log2 << SUB_BITS) | sub;
+}
+
+void FreeBlockIndex::insert(MemoryBlock* block) {
+    size_t cls = size_class(block->size);
+    bins[cls].insert({block->start, block->size, block});
+    nonempty_bins[cls / 64] |= (uint64_t)1 << (cls % 64);
+    by_size.insert({block->size, block->start, block});
+    free_bytes += block->size;
+}
+
+void FreeBlockIndex::erase(MemoryBlock* block) {
+    size_t cls = size_class(block->size);
+    bins[cls].erase({block->start, block->size, block});
+    if (bins[cls].empty())
+        nonempty_bins[cls / 64] &= ~((uint64_t)1 << (cls % 64));
+    if (by_size.erase({block->size, block->start, block}))
+        free_bytes -= block->size;
+}
+
+void FreeBlockIndex::clear() {
+    for (auto& bin : bins)
+        bin.clear();
+    by_size.clear();
+    for (auto& word : nonempty_bins)
+        word = 0;
+    free_bytes = 0;
+}
+
+MemoryBlock* FreeBlockIndex::first_fit(size_t size) const {
+    size_t cls = size_class(size);
+    const BinEntry* found = nullptr;
+
+    // Every block in a higher class fits, so only the lowest address of each
+    // of those bins is a candidate
+    for (size_t w = cls / 64; w < NUM_WORDS; ++w) {
+        uint64_t higher = nonempty_bins[w];
+        if (w == cls / 64)
+            higher &= cls % 64 == 63 ? 0 : ~(((uint64_t)2 << (cls % 64)) - 1);
+
+        while (higher) {
+            size_t c = w * 64 + __builtin_ctzll(higher);
+            higher &= higher - 1;
+            const BinEntry* candidate = &*bins[c].begin();
+            if (!found || candidate->start < found->start)
+                found = candidate;
+        }
+    }
+
+    // Blocks in the request's own class may be too small; scan in address
+    // order, but only up to the best candidate found so far
+    for (const BinEntry& entry : bins[cls]) {
+        if (found && entry.start > found->start)
+            break;
+        if (entry.size >= size)
+            return entry.block;
+    }
+
+    return found ? found->block : nullptr;
+}
+
+// Alignment padding means a block of any class may or may not fit, so every
+// bin that can hold size bytes is scanned in address order, each only up to
+// the best candidate found so far
+MemoryBlock* FreeBlockIndex::aligned_fit(size_t size, size_t alignment) const {
+    const BinEntry* found = nullptr;
+
+    for (size_t c = size_class(size); c < NUM_CLASSES; ++c) {
+        if (!(nonempty_bins[c / 64] & ((uint64_t)1 << (c % 64))))
+            continue;
+
+        for (const BinEntry& entry : bins[c]) {
+            if (found && entry.start > found->start)
+                break;
+            size_t pad = (alignment - entry.start % alignment) % alignment;
+            if (entry.size >= size && entry.size - size >= pad) {
+                found = &entry;
+                break;
+            }
+        }
+    }
+
+    return found ? found->block : nullptr;
+}
+
+MemoryBlock* FreeBlockIndex::best_fit(size_t size) const {
+    auto it = by_size.lower_bound({size, 0, nullptr});
+    return it == by_size.end() ? nullptr : it->block;
+}
+
+MemoryBlock* FreeBlockIndex::worst_fit(size_t size) const {
+    if (by_size.empty())
+        return nullptr;
+
+    size_t largest = by_size.rbegin()->size;
+    if (largest < size)
+        return nullptr;
+
+    // Lowest address among the largest blocks
+    return by_size.lower_bound({largest, 0, nullptr})->block;
+}
+
+size_t FreeBlockIndex::total_bytes() const {
+    return free_bytes;
+}
+
+size_t FreeBlockIndex::largest_size() const {
+    return by_size.empty() ? 0 : by_size.rbegin()->size;
+}
@@ -1,5 +1,5 @@
 #include "MemoryBlock.h"
 
 MemoryBlock::MemoryBlock(size_t s, size_t sz)
-	: start(s), size(sz), free(true), block_id(-1),
+	: start(s), size(sz), free(true), pinned(false), block_id(-1),
 	next(nullptr), prev(nullptr){}
\ No newline at end of file
@@ -1,26 +1,59 @@
 #include "MemoryManager.h"
 #include <iostream>
 #include <iomanip>
+#include <new>
 
 MemoryManager::MemoryManager()
     : head(nullptr),
       total_memory(0),
       next_block_id(1),
       alloc_requests(0),
-      alloc_failures(0) {}
+      alloc_failures(0),
+      block_index(0, std::hash<int>(), std::equal_to<int>(),
+                  PoolAllocator<std::pair<const int, MemoryBlock*>>(&index_pool)),
+      buddy_arena_id(-1),
+      sample_interval(0),
+      listener(nullptr),
+      auto_compact(false),
+      compact_step(0),
+      compaction_steps(0),
+      bytes_moved(0),
+      blocks_moved(0),
+      longest_step(0) {}
 
 MemoryManager::~MemoryManager() {
+    release_blocks();
+}
+
+MemoryBlock* MemoryManager::new_block(size_t start, size_t size) {
+    return new (block_pool.allocate(sizeof(MemoryBlock))) MemoryBlock(start, size);
+}
+
+void MemoryManager::delete_block(MemoryBlock* block) {
+    block->~MemoryBlock();
+    block_pool.deallocate(block, sizeof(MemoryBlock));
+}
+
+void MemoryManager::release_blocks() {
     MemoryBlock* curr = head;
     while (curr) {
         MemoryBlock* next = curr->next;
-        delete curr;
+        delete_block(curr);
         curr = next;
     }
+    head = nullptr;
+    block_index.clear();
+    free_index.clear();
+    buddy.clear();
+    buddy_arena_id = -1;
 }
 
 void MemoryManager::init(size_t size) {
+    release_blocks();
     total_memory = size;
-    head = new MemoryBlock(0, size);
+    head = new_block(0, size);
+    free_index.insert(head);
+    samples.clear();
 }
 
 void MemoryManager::dump() const {
@@ -31,6 +64,11 @@ void MemoryManager::dump() const {
 
         if (curr->free)
             std::cout << "FREE\n";
+        else if (curr->block_id == buddy_arena_id) {
+            std::cout << "USED (buddy arena)\n";
+            buddy.dump(curr->start);
+            std::cout << std::hex;
+        }
         else
             std::cout << "USED (id=" << curr->block_id << ")\n";
 
@@ -43,159 +81,318 @@ void MemoryManager::dump() const {
 MemoryBlock* MemoryManager::split_and_allocate(
     MemoryBlock* block, size_t req_size) {
 
+    free_index.erase(block);
+
+    block->pinned = false;
+
     // Exact fit
     if (block->size == req_size) {
         block->free = false;
         block->block_id = next_block_id++;
+        block_index[block->block_id] = block;
         return block;
     }
 
     // Split block
-    MemoryBlock* new_block =
-        new MemoryBlock(block->start + req_size,
-                        block->size - req_size);
+    MemoryBlock* rest =
+        new_block(block->start + req_size,
+                  block->size - req_size);
 
-    new_block->next = block->next;
-    new_block->prev = block;
+    rest->next = block->next;
+    rest->prev = block;
 
     if (block->next)
-        block->next->prev = new_block;
+        block->next->prev = rest;
 
-    block->next = new_block;
+    block->next = rest;
+    free_index.insert(rest);
 
     block->size = req_size;
     block->free = false;
     block->block_id = next_block_id++;
+    block_index[block->block_id] = block;
 
     return block;
 }
 
 int MemoryManager::allocate_first_fit(size_t req_size) {
     alloc_requests++;
-    MemoryBlock* curr = head;
+    MemoryBlock* first = free_index.first_fit(req_size);
+    if (!first && compact_for(req_size))
+        first = free_index.first_fit(req_size);
 
-    while (curr) {
-        if (curr->free && curr->size >= req_size) {
-            return split_and_allocate(curr, req_size)->block_id;
-        }
-        curr = curr->next;
-    }
-    alloc_failures++;
-    return -1;
+    if (!first)
+        return finish_request(-1);
+
+    return finish_request(split_and_allocate(first, req_size)->block_id);
 }
 
 int MemoryManager::allocate_best_fit(size_t req_size) {
     alloc_requests++;
-    MemoryBlock* curr = head;
-    MemoryBlock* best = nullptr;
-    size_t best_diff = SIZE_MAX;
+    MemoryBlock* best = free_index.best_fit(req_size);
+    if (!best && compact_for(req_size))
+        best = free_index.best_fit(req_size);
 
-    while (curr) {
-        if (curr->free && curr->size >= req_size) {
-            size_t diff = curr->size - req_size;
-            if (diff < best_diff) {
-                best_diff = diff;
-                best = curr;
-            }
-        }
-        curr = curr->next;
-    }
+    if (!best)
+        return finish_request(-1);
 
-    if (!best){
-        alloc_failures++;
-        return -1;
+    return finish_request(split_and_allocate(best, req_size)->block_id);
+}
+
+int MemoryManager::allocate_worst_fit(size_t req_size) {
+    alloc_requests++;
+    MemoryBlock* worst = free_index.worst_fit(req_size);
+    if (!worst && compact_for(req_size))
+        worst = free_index.worst_fit(req_size);
+
+    if (!worst)
+        return finish_request(-1);
+
+    return finish_request(split_and_allocate(worst, req_size)->block_id);
+}
+
+int MemoryManager::allocate_aligned(size_t req_size, size_t alignment) {
+    alloc_requests++;
+    MemoryBlock* block = free_index.aligned_fit(req_size, alignment);
+    if (!block && compact_for(req_size))
+        block = free_index.aligned_fit(req_size, alignment);
+
+    if (!block)
+        return finish_request(-1);
+
+    // Split the padding off the front as its own free block
+    size_t pad = (alignment - block->start % alignment) % alignment;
+    if (pad) {
+        free_index.erase(block);
+        MemoryBlock* aligned = new_block(block->start + pad, block->size - pad);
+
+        aligned->next = block->next;
+        aligned->prev = block;
+        if (block->next)
+            block->next->prev = aligned;
+        block->next = aligned;
+        block->size = pad;
+
+        free_index.insert(block);
+        free_index.insert(aligned);
+        block = aligned;
     }
 
-    return split_and_allocate(best, req_size)->block_id;
+    block = split_and_allocate(block, req_size);
+    block->pinned = true;
+    return finish_request(block->block_id);
 }
 
-int MemoryManager::allocate_worst_fit(size_t req_size) {
+int MemoryManager::allocate_buddy(size_t req_size) {
     alloc_requests++;
-    MemoryBlock* curr = head;
-    MemoryBlock* worst = nullptr;
-    size_t worst_size = 0;
 
-    while (curr) {
-        if (curr->free && curr->size >= req_size) {
-            if (curr->size > worst_size) {
-                worst_size = curr->size;
-                worst = curr;
-            }
-        }
-        curr = curr->next;
+    if (buddy_arena_id == -1 && !reserve_buddy_arena())
+        return finish_request(-1);
+
+    if (!buddy.allocate(next_block_id, req_size)) {
+        if (buddy.empty())
+            release_buddy_arena();
+        return finish_request(-1);
     }
 
-    if (!worst){
+    return finish_request(next_block_id++);
+}
+
+// Counts a failed request and takes a sample if one is due
+int MemoryManager::finish_request(int block_id) {
+    if (block_id == -1)
         alloc_failures++;
-        return -1;
+
+    if (sample_interval && alloc_requests % sample_interval == 0) {
+        FragmentationSample sample;
+        sample.requests = alloc_requests;
+        sample.failures = alloc_failures;
+        sample.free_bytes = total_free_memory();
+        sample.largest_free = largest_free_block();
+        sample.used_bytes = used_memory();
+        sample.external_fragmentation = external_fragmentation();
+        samples.push_back(sample);
     }
+    return block_id;
+}
+
+bool MemoryManager::reserve_buddy_arena() {
+    MemoryBlock* largest = free_index.worst_fit(0);
+    if (!largest || largest->size < BuddyAllocator::min_block_size())
+        return false;
+
+    size_t arena_size = BuddyAllocator::min_block_size();
+    while (arena_size * 2 <= largest->size)
+        arena_size *= 2;
 
-    return split_and_allocate(worst, req_size)->block_id;
+    MemoryBlock* arena =
+        split_and_allocate(free_index.first_fit(arena_size), arena_size);
+    buddy_arena_id = arena->block_id;
+    buddy.init(arena_size);
+    return true;
 }
 
+void MemoryManager::release_buddy_arena() {
+    auto it = block_index.find(buddy_arena_id);
+    MemoryBlock* arena = it->second;
+    block_index.erase(it);
 
+    buddy.clear();
+    buddy_arena_id = -1;
+    coalesce_free(arena);
+}
 
 bool MemoryManager::free_block(int block_id) {
-    MemoryBlock* curr = head;
-    while (curr) {
-        if (!curr->free && curr->block_id == block_id) {
-
-            // Mark block as free
-            curr->free = true;
-            curr->block_id = -1;
-
-            // Combine with next block if free
-            if (curr->next && curr->next->free) {
-                MemoryBlock* next = curr->next;
-                curr->size += next->size;
-                curr->next = next->next;
-                if (next->next)
-                    next->next->prev = curr;
-                delete next;
-            }
-
-            // Combine with previous block if free
-            if (curr->prev && curr->prev->free) {
-                MemoryBlock* prev = curr->prev;
-                prev->size += curr->size;
-                prev->next = curr->next;
-                if (curr->next)
-                    curr->next->prev = prev;
-                delete curr;
-            }
-
-            return true;
-        }
+    if (buddy.free(block_id)) {
+        if (buddy.empty())
+            release_buddy_arena();
+        return true;
+    }
 
-        curr = curr->next;
+    // The arena itself is owned by the buddy allocator
+    if (block_id == buddy_arena_id)
+        return false;
+
+    auto it = block_index.find(block_id);
+    if (it == block_index.end())
+        return false; //block ID not found
+
+    MemoryBlock* curr = it->second;
+    block_index.erase(it);
+    coalesce_free(curr);
+
+    return true;
+}
+
+void MemoryManager::coalesce_free(MemoryBlock* curr) {
+    // Mark block as free
+    curr->free = true;
+    curr->block_id = -1;
+
+    // Combine with next block if free
+    if (curr->next && curr->next->free) {
+        MemoryBlock* next = curr->next;
+        free_index.erase(next);
+        curr->size += next->size;
+        curr->next = next->next;
+        if (next->next)
+            next->next->prev = curr;
+        delete_block(next);
     }
 
-    return false; //block ID not found
+    // Combine with previous block if free
+    if (curr->prev && curr->prev->free) {
+        MemoryBlock* prev = curr->prev;
+        free_index.erase(prev);
+        prev->size += curr->size;
+        prev->next = curr->next;
+        if (curr->next)
+            curr->next->prev = prev;
+        delete_block(curr);
+        curr = prev;
+    }
+
+    free_index.insert(curr);
 }
 
 
-size_t MemoryManager::total_free_memory() const {
-    size_t total = 0;
-    MemoryBlock* curr = head;
+// Only worth it when the request fails for want of a large enough block
+bool MemoryManager::compact_for(size_t req_size) {
+    if (!auto_compact || total_free_memory() < req_size)
+        return false;
+    return compact(compact_step) > 0;
+}
 
-    while (curr) {
-        if (curr->free)
-            total += curr->size;
-        curr = curr->next;
+size_t MemoryManager::compact(size_t max_bytes) {
+    size_t moved = 0;
+
+    // Free neighbours are always coalesced, so the block after the lowest
+    // free block is allocated. Swapping the two moves the hole up, where it
+    // merges with the next one.
+    MemoryBlock* hole = free_index.first_fit(0);
+    while (hole && hole->next) {
+        MemoryBlock* block = hole->next;
+
+        // Moving an aligned block would lose its alignment. The hole stays
+        // below it, and compaction carries on from the next hole above.
+        if (block->pinned) {
+            hole = block->next;
+            while (hole && !hole->free)
+                hole = hole->next;
+            continue;
+        }
+
+        if (moved > 0 && max_bytes && moved + block->size > max_bytes)
+            break;
+
+        free_index.erase(hole);
+        size_t old_start = block->start;
+        block->start = hole->start;
+        hole->start = block->start + block->size;
+
+        block->prev = hole->prev;
+        if (hole->prev)
+            hole->prev->next = block;
+        else
+            head = block;
+        hole->next = block->next;
+        if (block->next)
+            block->next->prev = hole;
+        block->next = hole;
+        hole->prev = block;
+
+        if (hole->next && hole->next->free) {
+            MemoryBlock* next = hole->next;
+            free_index.erase(next);
+            hole->size += next->size;
+            hole->next = next->next;
+            if (next->next)
+                next->next->prev = hole;
+            delete_block(next);
+        }
+        free_index.insert(hole);
+
+        moved += block->size;
+        blocks_moved++;
+        if (listener)
+            listener->on_relocate(block->block_id, old_start, block->start, block->size);
+    }
+
+    if (moved) {
+        compaction_steps++;
+        bytes_moved += moved;
+        if (moved > longest_step)
+            longest_step = moved;
     }
+    return moved;
+}
+
+void MemoryManager::set_auto_compaction(bool on, size_t step_bytes) {
+    auto_compact = on;
+    compact_step = step_bytes;
+}
+
+void MemoryManager::set_relocation_listener(RelocationListener* l) {
+    listener = l;
+}
+
+RelocationListener* MemoryManager::get_relocation_listener() const {
+    return listener;
+}
 
-    return total;
+size_t MemoryManager::get_bytes_moved() const {
+    return bytes_moved;
+}
+
+size_t MemoryManager::total_free_memory() const {
+    return free_index.total_bytes() + buddy.free_bytes();
 }
 
 size_t MemoryManager::largest_free_block() const {
-    size_t largest = 0;
-    MemoryBlock* curr = head;
+    size_t largest = free_index.largest_size();
 
-    while (curr) {
-        if (curr->free && curr->size > largest)
-            largest = curr->size;
-        curr = curr->next;
-    }
+    if (buddy.largest_free_block() > largest)
+        largest = buddy.largest_free_block();
 
     return largest;
 }
@@ -210,17 +407,13 @@ double MemoryManager::external_fragmentation() const {
     return 1.0 - (double)largest / total_free;
 }
 
-double MemoryManager::memory_utilization() const {
-    size_t used = 0;
-    MemoryBlock* curr = head;
-
-    while (curr) {
-        if (!curr->free)
-            used += curr->size;
-        curr = curr->next;
-    }
+// Everything not free in the block list or in the buddy arena
+size_t MemoryManager::used_memory() const {
+    return total_memory - total_free_memory();
+}
 
-    return (double)used / total_memory;
+double MemoryManager::memory_utilization() const {
+    return (double)used_memory() / total_memory;
 }
 
 size_t MemoryManager::get_alloc_requests() const {
@@ -242,23 +435,51 @@ double MemoryManager::allocation_failure_rate() const {
 }
 
 size_t MemoryManager::internal_fragmentation() const {
-    return 0;
+    // First, best and worst fit allocate exactly the requested size
+    return buddy.internal_fragmentation();
 }
 
 size_t MemoryManager::get_block_start(int block_id) const {
-    MemoryBlock* curr = head;
+    if (buddy.contains(block_id))
+        return block_index.at(buddy_arena_id)->start + buddy.block_offset(block_id);
 
-    while (curr) {
-        if (!curr->free && curr->block_id == block_id) {
-            return curr->start;
-        }
-        curr = curr->next;
-    }
+    auto it = block_index.find(block_id);
+    if (it == block_index.end() || block_id == buddy_arena_id)
+        return static_cast<size_t>(-1);
 
-    return static_cast<size_t>(-1);
+    return it->second->start;
 }
 
 
+void MemoryManager::set_fragmentation_sampling(size_t interval) {
+    sample_interval = interval;
+}
+
+size_t MemoryManager::num_fragmentation_samples() const {
+    return samples.size();
+}
+
+void MemoryManager::write_fragmentation_csv(std::ostream& out) const {
+    out << "requests,failures,free_bytes,largest_free,used_bytes,external_fragmentation\n";
+    for (const FragmentationSample& s : samples) {
+        out << s.requests << "," << s.failures << "," << s.free_bytes << ","
+            << s.largest_free << "," << s.used_bytes << "," << s.external_fragmentation << "\n";
+    }
+}
+
+void MemoryManager::write_fragmentation_json(std::ostream& out) const {
+    out << "[\n";
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const FragmentationSample& s = samples[i];
+        out << "  {\"requests\": " << s.requests << ", \"failures\": " << s.failures
+            << ", \"free_bytes\": " << s.free_bytes << ", \"largest_free\": " << s.largest_free
+            << ", \"used_bytes\": " << s.used_bytes
+            << ", \"external_fragmentation\": " << s.external_fragmentation << "}"
+            << (i + 1 < samples.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
 void MemoryManager::print_stats() const {
     std::cout << "--- Memory Stats ---\n";
     std::cout << "Total free memory: " << total_free_memory() << "\n";
@@ -268,7 +489,14 @@ void MemoryManager::print_stats() const {
     std::cout << "Allocation failures: " << get_alloc_failures() << "\n";
     std::cout << "Allocation success rate: "<< allocation_success_rate() *100 << "%\n";
     std::cout << "Allocation failure rate: "<< allocation_failure_rate() * 100 << "%\n";
-    std::cout << "Internal fragmentation: " << internal_fragmentation() << " bytes (exact-fit allocation)\n";
+    std::cout << "Internal fragmentation: " << internal_fragmentation()
+              << (buddy_arena_id == -1 ? " bytes (exact-fit allocation)\n"
+                                       : " bytes (buddy power-of-two rounding)\n");
     std::cout << "External fragmentation: " << external_fragmentation() << "\n";
+    if (compaction_steps) {
+        std::cout << "Compaction: " << compaction_steps << " steps moved " << bytes_moved
+                  << " bytes in " << blocks_moved << " blocks (longest step "
+                  << longest_step << " bytes)\n";
+    }
 }
 
@@ -0,0 +1,37 @@
+#include "NodePool.h"
+
+NodePool::NodePool()
+    : node_size(0),
+      chunk_used(NODES_PER_CHUNK),
+      free_list(nullptr) {}
+
+void* NodePool::allocate(size_t size) {
+    if (node_size == 0)
+        node_size = size < sizeof(FreeNode) ? sizeof(FreeNode) : size;
+    else if (size > node_size)
+        return ::operator new(size);
+
+    if (free_list) {
+        FreeNode* node = free_list;
+        free_list = node->next;
+        return node;
+    }
+
+    if (chunk_used == NODES_PER_CHUNK) {
+        chunks.emplace_back(new char[node_size * NODES_PER_CHUNK]);
+        chunk_used = 0;
+    }
+
+    return chunks.back().get() + node_size * chunk_used++;
+}
+
+void NodePool::deallocate(void* p, size_t size) {
+    if (size > node_size) {
+        ::operator delete(p);
+        return;
+    }
+
+    FreeNode* node = static_cast<FreeNode*>(p);
+    node->next = free_list;
+    free_list = node;
+}
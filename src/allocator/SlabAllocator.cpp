@@ -0,0 +1,187 @@
+#include "SlabAllocator.h"
+#include <iostream>
+#include <iterator>
+
+SlabAllocator::SlabAllocator(MemoryManager& m)
+    : mm(m) {}
+
+// The slab entry and slot of a live object, or nullptr
+const SlabAllocator::SlabEntry* SlabAllocator::find_object(int object_id, size_t& slot) const {
+    if (object_id <= 0)
+        return nullptr;
+
+    size_t number = (size_t)(object_id - 1) / MAX_OBJECTS_PER_SLAB;
+    slot = (size_t)(object_id - 1) % MAX_OBJECTS_PER_SLAB;
+    if (number >= slabs.size() || !slabs[number].cache
+        || !(slabs[number].slab->allocated & (1ULL << slot)))
+        return nullptr;
+    return &slabs[number];
+}
+
+SlabAllocator::SlabCache& SlabAllocator::cache_for(size_t object_size) {
+    auto it = caches.find(object_size);
+    if (it != caches.end())
+        return it->second;
+
+    SlabCache& cache = caches[object_size];
+    cache.object_size = object_size;
+    cache.slab_size = MIN_SLAB_SIZE;
+    while (cache.slab_size < object_size * MIN_OBJECTS_PER_SLAB)
+        cache.slab_size *= 2;
+    cache.objects_per_slab = cache.slab_size / object_size;
+    cache.active_objects = 0;
+    cache.requested_bytes = 0;
+    return cache;
+}
+
+bool SlabAllocator::grow(SlabCache& cache) {
+    int block_id = mm.allocate_first_fit(cache.slab_size);
+    if (block_id == -1)
+        return false;
+
+    Slab slab;
+    slab.block_id = block_id;
+    slab.in_use = 0;
+    slab.allocated = 0;
+    slab.free_slots.reserve(cache.objects_per_slab);
+    for (size_t slot = cache.objects_per_slab; slot > 0; --slot)
+        slab.free_slots.push_back(slot - 1);
+    slab.requested.assign(cache.objects_per_slab, 0);
+
+    if (free_numbers.empty()) {
+        slab.number = slabs.size();
+        slabs.emplace_back();
+    } else {
+        slab.number = free_numbers.back();
+        free_numbers.pop_back();
+    }
+
+    cache.partial.push_back(std::move(slab));
+    SlabEntry& entry = slabs[cache.partial.back().number];
+    entry.cache = &cache;
+    entry.slab = std::prev(cache.partial.end());
+    slab_of_block[block_id] = entry.slab->number;
+    return true;
+}
+
+int SlabAllocator::allocate(size_t size) {
+    if (size == 0)
+        size = 1;
+    size_t object_size = (size + OBJECT_ALIGN - 1) / OBJECT_ALIGN * OBJECT_ALIGN;
+    SlabCache& cache = cache_for(object_size);
+
+    // Partial slabs first, then a cached empty slab, then a new one
+    if (cache.partial.empty()) {
+        if (!cache.empty.empty())
+            cache.partial.splice(cache.partial.end(), cache.empty, cache.empty.begin());
+        else if (!grow(cache))
+            return -1;
+    }
+
+    SlabRef slab = cache.partial.begin();
+    size_t slot = slab->free_slots.back();
+    slab->free_slots.pop_back();
+    slab->in_use++;
+    slab->allocated |= 1ULL << slot;
+    slab->requested[slot] = size;
+
+    if (slab->free_slots.empty())
+        cache.full.splice(cache.full.end(), cache.partial, slab);
+
+    cache.active_objects++;
+    cache.requested_bytes += size;
+
+    return (int)(slab->number * MAX_OBJECTS_PER_SLAB + slot + 1);
+}
+
+bool SlabAllocator::free(int object_id) {
+    size_t slot;
+    const SlabEntry* entry = find_object(object_id, slot);
+    if (!entry)
+        return false;
+
+    SlabCache& cache = *entry->cache;
+    SlabRef slab = entry->slab;
+    bool was_full = slab->free_slots.empty();
+
+    slab->free_slots.push_back(slot);
+    slab->allocated &= ~(1ULL << slot);
+    slab->in_use--;
+    cache.active_objects--;
+    cache.requested_bytes -= slab->requested[slot];
+
+    if (slab->in_use == 0) {
+        // Keep one empty slab per cache, return the rest to the heap
+        std::list<Slab>& from = was_full ? cache.full : cache.partial;
+        if (cache.empty.empty()) {
+            cache.empty.splice(cache.empty.end(), from, slab);
+        } else {
+            mm.free_block(slab->block_id);
+            slab_of_block.erase(slab->block_id);
+            slabs[slab->number].cache = nullptr;
+            free_numbers.push_back(slab->number);
+            from.erase(slab);
+        }
+    } else if (was_full) {
+        cache.partial.splice(cache.partial.end(), cache.full, slab);
+    }
+
+    return true;
+}
+
+size_t SlabAllocator::object_address(int object_id) const {
+    size_t slot;
+    const SlabEntry* entry = find_object(object_id, slot);
+    if (!entry)
+        return static_cast<size_t>(-1);
+
+    return mm.get_block_start(entry->slab->block_id) + slot * entry->cache->object_size;
+}
+
+bool SlabAllocator::owns_block(int block_id) const {
+    return slab_of_block.count(block_id) != 0;
+}
+
+void SlabAllocator::reset() {
+    caches.clear();
+    slabs.clear();
+    free_numbers.clear();
+    slab_of_block.clear();
+}
+
+size_t SlabAllocator::wasted_bytes() const {
+    size_t wasted = 0;
+    for (const auto& entry : caches) {
+        const SlabCache& cache = entry.second;
+        size_t slabs = cache.partial.size() + cache.full.size() + cache.empty.size();
+        size_t tail = cache.slab_size - cache.objects_per_slab * cache.object_size;
+        wasted += slabs * tail
+                + cache.active_objects * cache.object_size - cache.requested_bytes;
+    }
+    return wasted;
+}
+
+void SlabAllocator::print_stats() const {
+    std::cout << "--- Slab Stats ---\n";
+
+    for (const auto& entry : caches) {
+        const SlabCache& cache = entry.second;
+        size_t slabs = cache.partial.size() + cache.full.size() + cache.empty.size();
+        size_t tail = cache.slab_size - cache.objects_per_slab * cache.object_size;
+        size_t rounding = cache.active_objects * cache.object_size - cache.requested_bytes;
+
+        std::cout << "Cache " << cache.object_size << "B: "
+                  << "slab size " << cache.slab_size
+                  << ", objects/slab " << cache.objects_per_slab
+                  << ", active objects " << cache.active_objects << "\n";
+        std::cout << "  Slabs: " << slabs
+                  << " (partial " << cache.partial.size()
+                  << ", full " << cache.full.size()
+                  << ", empty " << cache.empty.size() << ")\n";
+        std::cout << "  Wasted bytes: " << slabs * tail + rounding
+                  << " (slab tail " << slabs * tail
+                  << ", object rounding " << rounding << ")\n";
+    }
+
+    std::cout << "Total wasted bytes: " << wasted_bytes() << "\n";
+}
@@ -1,56 +1,442 @@
 #include "cache/Cache.h"
+#include <algorithm>
 #include <iostream>
 
 Cache::Cache(size_t csize,
              size_t bsize,
              size_t assoc,
-             const std::string& policy)
+             const std::string& policy,
+             uint64_t s)
     : cache_size(csize),
       block_size(bsize),
       associativity(assoc),
-      replacement_policy(policy),
-      timestamp(0),
-      hits(0),
-      misses(0),
-      hit_time(1),
-      miss_penalty(10),
-      total_accesses(0),
-      total_cycles(0),
-      next_level(nullptr) {
+      replacement_policy(ReplacementPolicy::LRU),
+      seed(s),
+      write_policy(WritePolicy::WRITE_BACK),
+      write_miss_policy(WriteMissPolicy::WRITE_ALLOCATE),
+      inclusion(InclusionPolicy::NINE),
+      latency(DEFAULT_LATENCY),
+      memory_latency(DEFAULT_MEMORY_LATENCY),
+      memory_model(nullptr),
+      next_level(nullptr),
+      coherent(false),
+      prefetcher(nullptr) {
 
-    num_sets = cache_size / (block_size * associativity);
+    if (!parse_replacement_policy(policy, replacement_policy))
+        std::cerr << "Unknown replacement policy " << policy << ", using LRU\n";
+
+    if (associativity > CacheSet::MAX_WAYS) {
+        std::cerr << "Associativity " << associativity << " not supported, using "
+                  << CacheSet::MAX_WAYS << "\n";
+        associativity = CacheSet::MAX_WAYS;
+    }
 
-    for (size_t i = 0; i < num_sets; ++i) {
-        sets.emplace_back(associativity);
+    switch (replacement_policy) {
+    case ReplacementPolicy::LRU:
+        access_fn = &Cache::access_as<ReplacementPolicy::LRU>;
+        victim_fn = &Cache::victim_as<ReplacementPolicy::LRU>;
+        break;
+    case ReplacementPolicy::FIFO:
+        access_fn = &Cache::access_as<ReplacementPolicy::FIFO>;
+        victim_fn = &Cache::victim_as<ReplacementPolicy::FIFO>;
+        break;
+    case ReplacementPolicy::PLRU:
+        access_fn = &Cache::access_as<ReplacementPolicy::PLRU>;
+        victim_fn = &Cache::victim_as<ReplacementPolicy::PLRU>;
+        break;
+    case ReplacementPolicy::SRRIP:
+        access_fn = &Cache::access_as<ReplacementPolicy::SRRIP>;
+        victim_fn = &Cache::victim_as<ReplacementPolicy::SRRIP>;
+        break;
+    case ReplacementPolicy::BRRIP:
+        access_fn = &Cache::access_as<ReplacementPolicy::BRRIP>;
+        victim_fn = &Cache::victim_as<ReplacementPolicy::BRRIP>;
+        break;
+    case ReplacementPolicy::LFU:
+        access_fn = &Cache::access_as<ReplacementPolicy::LFU>;
+        victim_fn = &Cache::victim_as<ReplacementPolicy::LFU>;
+        break;
+    case ReplacementPolicy::RANDOM:
+        access_fn = &Cache::access_as<ReplacementPolicy::RANDOM>;
+        victim_fn = &Cache::victim_as<ReplacementPolicy::RANDOM>;
+        break;
     }
+
+    num_sets = cache_size / (block_size * associativity);
+    reset();
 }
 
+void Cache::reset() {
+    arrays.init(num_sets, associativity, replacement_policy, seed);
+    if (prefetcher)
+        arrays.prefetch_ready.assign(arrays.tags.size(), 0);
+    if (coherent)
+        arrays.touched.assign(arrays.tags.size(), 0);
+    pollution_filter.assign(prefetcher ? POLLUTION_FILTER_SIZE : 0, 0);
+
+    timestamp = 0;
+    hits = 0;
+    misses = 0;
+    reads = 0;
+    writes = 0;
+    writebacks = 0;
+    writeback_bytes = 0;
+    write_throughs = 0;
+    victim_fills = 0;
+    back_invalidations = 0;
+    total_accesses = 0;
+    total_cycles = 0;
+    prefetch = PrefetchStats();
+}
 
 void Cache::set_next_level(Cache* next) {
+    if (next_level) {
+        std::vector<Cache*>& above = next_level->prev_levels;
+        above.erase(std::remove(above.begin(), above.end(), this), above.end());
+    }
+
     next_level = next;
+    if (next_level)
+        next_level->prev_levels.push_back(this);
+}
+
+void Cache::set_prefetcher(Prefetcher* p) {
+    prefetcher = p;
+    std::fill(arrays.prefetched.begin(), arrays.prefetched.end(), 0);
+    if (prefetcher) {
+        arrays.prefetch_ready.assign(arrays.tags.size(), 0);
+        pollution_filter.assign(POLLUTION_FILTER_SIZE, 0);
+    }
+}
+
+Prefetcher* Cache::get_prefetcher() const {
+    return prefetcher;
+}
+
+void Cache::set_coherent(bool on) {
+    coherent = on;
+}
+
+void Cache::set_write_policy(WritePolicy policy, WriteMissPolicy miss_policy) {
+    write_policy = policy;
+    write_miss_policy = miss_policy;
+}
+
+void Cache::set_inclusion(InclusionPolicy policy) {
+    inclusion = policy;
+}
+
+void Cache::set_latency(size_t cycles) {
+    latency = cycles;
+}
+
+void Cache::set_memory_latency(size_t cycles) {
+    memory_latency = cycles;
+}
+
+void Cache::set_memory_model(MemoryLatencyModel* model) {
+    memory_model = model;
+}
+
+size_t Cache::memory_cycles(size_t address) {
+    return memory_model ? memory_model->memory_latency(address) : memory_latency;
+}
+
+size_t Cache::access(size_t address, AccessType type) {
+    bool dirty = false;
+    return (this->*access_fn)(address, type, dirty);
+}
+
+bool Cache::exclusive_of_above() const {
+    return inclusion == InclusionPolicy::EXCLUSIVE && !prev_levels.empty();
+}
+
+// Lines are split into at most 64 chunks; without access sizes in the
+// trace, an access touches the chunk holding its first byte
+uint64_t Cache::chunk_of(size_t address) const {
+    size_t chunk_bytes = (block_size + 63) / 64;
+    return 1ULL << (address % block_size / chunk_bytes);
 }
 
-void Cache::access(size_t address) {
+template <ReplacementPolicy Policy>
+size_t Cache::access_as(size_t address, AccessType type, bool& dirty_out) {
     timestamp++;
     total_accesses++;
 
+    bool write = type == AccessType::WRITE;
+    if (write)
+        writes++;
+    else
+        reads++;
+
     size_t block_addr = address / block_size;
     size_t set_index = block_addr % num_sets;
     size_t tag = block_addr / num_sets;
+    size_t cycles = latency;
 
-    bool hit = false;
-    sets[set_index].access(tag, replacement_policy, timestamp, hit);
+    CacheSet set(arrays, set_index);
+    int way = set.template lookup<Policy>(tag, timestamp);
 
-    if (hit) {
+    if (way != -1) {
         hits++;
-        total_cycles += hit_time;
+        if (coherent)
+            set.touch(way, chunk_of(address), false);
+
+        PrefetchTrigger trigger = PrefetchTrigger::HIT;
+        uint64_t ready_at;
+        if (prefetcher && set.take_prefetched(way, ready_at)) {
+            trigger = PrefetchTrigger::PREFETCH_HIT;
+            prefetch.useful++;
+            // Wait for the rest of the prefetch instead of a full miss
+            if (ready_at > total_cycles + cycles) {
+                prefetch.late++;
+                cycles = ready_at - total_cycles;
+            }
+        }
+
+        if (write) {
+            if (write_policy == WritePolicy::WRITE_BACK)
+                set.mark_dirty(way);
+            else
+                cycles += write_through(address);
+        } else if (exclusive_of_above()) {
+            // The line moves up into the level that missed
+            dirty_out = set.is_dirty(way);
+            set.invalidate(way, Policy);
+        }
+
+        total_cycles += cycles;
+        if (prefetcher)
+            issue_prefetches<Policy>(block_addr, trigger);
+        return cycles;
+    }
+
+    misses++;
+
+    if (prefetcher) {
+        uint64_t& recent = pollution_filter[block_addr % POLLUTION_FILTER_SIZE];
+        if (recent == block_addr + 1) {
+            prefetch.polluting++;
+            recent = 0;
+        }
+    }
+
+    if (write && write_miss_policy == WriteMissPolicy::NO_WRITE_ALLOCATE) {
+        // The store goes around this level
+        bool ignored = false;
+        cycles += fetch(address, AccessType::WRITE, ignored);
+    } else if (exclusive_of_above() && !write) {
+        // Lines from below pass straight through to the level above
+        cycles += fetch(address, AccessType::READ, dirty_out);
     } else {
-        misses++;
-        total_cycles += hit_time  + miss_penalty;
-        if (next_level) {
-            next_level->access(address);
+        bool lower_dirty = false;
+        cycles += fetch(address, AccessType::READ, lower_dirty);
+
+        CacheVictim victim;
+        bool dirty = (write && write_policy == WritePolicy::WRITE_BACK) || lower_dirty;
+        int filled = set.template fill<Policy>(tag, timestamp, dirty, victim);
+        if (coherent)
+            set.touch(filled, chunk_of(address), true);
+        cycles += evicted(victim, set_index, false);
+
+        if (write && write_policy == WritePolicy::WRITE_THROUGH)
+            cycles += write_through(address);
+    }
+
+    total_cycles += cycles;
+    if (prefetcher)
+        issue_prefetches<Policy>(block_addr, PrefetchTrigger::MISS);
+    return cycles;
+}
+
+// Whole lines arrive from above, so a miss allocates without fetching
+template <ReplacementPolicy Policy>
+size_t Cache::victim_as(size_t address, bool dirty) {
+    timestamp++;
+
+    size_t block_addr = address / block_size;
+    size_t set_index = block_addr % num_sets;
+    size_t tag = block_addr / num_sets;
+    size_t cycles = latency;
+
+    CacheSet set(arrays, set_index);
+    int way = set.template lookup<Policy>(tag, timestamp);
+
+    if (way != -1) {
+        if (dirty) {
+            if (write_policy == WritePolicy::WRITE_BACK)
+                set.mark_dirty(way);
+            else
+                cycles += send_down(address, true);
         }
+        return cycles;
     }
+
+    if (!exclusive_of_above() && write_miss_policy == WriteMissPolicy::NO_WRITE_ALLOCATE)
+        return cycles + send_down(address, dirty);
+
+    if (exclusive_of_above())
+        victim_fills++;
+
+    bool keep_dirty = dirty && write_policy == WritePolicy::WRITE_BACK;
+    CacheVictim victim;
+    set.template fill<Policy>(tag, timestamp, keep_dirty, victim);
+    cycles += evicted(victim, set_index, false);
+
+    if (dirty && !keep_dirty)
+        cycles += send_down(address, true);
+    return cycles;
+}
+
+// Prefetched lines go through the same fill as demand misses. Their data
+// is ready once the fetch from below would have completed; that fetch is
+// off the critical path, so it adds no cycles here.
+template <ReplacementPolicy Policy>
+void Cache::issue_prefetches(uint64_t line, PrefetchTrigger trigger) {
+    prefetch_lines.clear();
+    prefetcher->observe(line, trigger, prefetch_lines);
+
+    for (uint64_t target : prefetch_lines) {
+        size_t set_index = target % num_sets;
+        CacheSet set(arrays, set_index);
+        if (set.find(target / num_sets) != -1)
+            continue;
+
+        bool lower_dirty = false;
+        size_t ready_at = total_cycles + fetch(target * block_size, AccessType::READ, lower_dirty);
+
+        CacheVictim victim;
+        int way = set.template fill<Policy>(target / num_sets, timestamp, lower_dirty, victim);
+        set.mark_prefetched(way, ready_at);
+        if (coherent)
+            set.touch(way, 0, true);
+        prefetch.issued++;
+        evicted(victim, set_index, true);
+    }
+}
+
+size_t Cache::fetch(size_t address, AccessType type, bool& dirty) {
+    if (!next_level)
+        return memory_cycles(address);
+    return (next_level->*next_level->access_fn)(address, type, dirty);
+}
+
+// An inclusive level takes the line out of the levels above as well, and
+// keeps the data if any copy up there was dirty. Dirty lines are written
+// back; an exclusive level below also takes clean ones.
+size_t Cache::evicted(const CacheVictim& victim, size_t set_index, bool by_prefetch) {
+    if (!victim.valid)
+        return 0;
+
+    uint64_t line = victim.tag * num_sets + set_index;
+    if (victim.prefetched)
+        prefetch.unused++;
+    else if (by_prefetch)
+        pollution_filter[line % POLLUTION_FILTER_SIZE] = line + 1;
+
+    bool dirty = victim.dirty;
+    if (inclusion == InclusionPolicy::INCLUSIVE) {
+        for (Cache* above : prev_levels)
+            dirty = above->back_invalidate(line * block_size, block_size) || dirty;
+    }
+
+    if (dirty || (next_level && next_level->exclusive_of_above()))
+        return send_down(line * block_size, dirty);
+    return 0;
+}
+
+// Writebacks cost what the level below spends taking them. Clean victim
+// fills move alongside the refill and are free.
+size_t Cache::send_down(size_t address, bool dirty) {
+    if (dirty) {
+        writebacks++;
+        writeback_bytes += block_size;
+    }
+
+    if (next_level) {
+        size_t cycles = (next_level->*next_level->victim_fn)(address, dirty);
+        return dirty ? cycles : 0;
+    }
+    return dirty ? memory_cycles(address) : 0;
+}
+
+size_t Cache::write_through(size_t address) {
+    write_throughs++;
+    bool ignored = false;
+    return fetch(address, AccessType::WRITE, ignored);
+}
+
+bool Cache::back_invalidate(size_t address, size_t bytes) {
+    bool dirty = false;
+
+    for (size_t a = address; a < address + bytes; a += block_size) {
+        size_t block_addr = a / block_size;
+        CacheSet set(arrays, block_addr % num_sets);
+        int way = set.find(block_addr / num_sets);
+        if (way == -1)
+            continue;
+
+        dirty = set.is_dirty(way) || dirty;
+        set.invalidate(way, replacement_policy);
+        back_invalidations++;
+    }
+
+    for (Cache* above : prev_levels)
+        dirty = above->back_invalidate(address, bytes) || dirty;
+    return dirty;
+}
+
+bool Cache::probe(size_t address, bool& dirty, uint64_t& touched) {
+    size_t block_addr = address / block_size;
+    CacheSet set(arrays, block_addr % num_sets);
+    int way = set.find(block_addr / num_sets);
+    if (way == -1)
+        return false;
+
+    dirty = set.is_dirty(way);
+    touched = coherent ? set.touched(way) : 0;
+    return true;
+}
+
+size_t Cache::snoop_invalidate(size_t address) {
+    size_t block_addr = address / block_size;
+    CacheSet set(arrays, block_addr % num_sets);
+    int way = set.find(block_addr / num_sets);
+    if (way == -1)
+        return 0;
+
+    size_t cycles = 0;
+    if (set.is_dirty(way))
+        cycles = send_down(block_addr * block_size, true);
+    set.invalidate(way, replacement_policy);
+    return cycles;
+}
+
+size_t Cache::snoop_downgrade(size_t address) {
+    size_t block_addr = address / block_size;
+    CacheSet set(arrays, block_addr % num_sets);
+    int way = set.find(block_addr / num_sets);
+    if (way == -1 || !set.is_dirty(way))
+        return 0;
+
+    set.clean(way);
+    return send_down(block_addr * block_size, true);
+}
+
+size_t Cache::get_block_size() const {
+    return block_size;
+}
+
+size_t Cache::get_num_sets() const {
+    return num_sets;
+}
+
+size_t Cache::get_associativity() const {
+    return associativity;
+}
+
+size_t Cache::get_latency() const {
+    return latency;
 }
 
 double Cache::amat() const {
@@ -58,6 +444,23 @@ double Cache::amat() const {
     return (double)total_cycles / total_accesses;
 }
 
+double Cache::hit_rate() const {
+    size_t total = hits + misses;
+    if (total == 0) return 0.0;
+    return (double)hits / total;
+}
+
+size_t Cache::get_hits() const {
+    return hits;
+}
+
+size_t Cache::get_misses() const {
+    return misses;
+}
+
+const PrefetchStats& Cache::prefetch_stats() const {
+    return prefetch;
+}
 
 void Cache::print_stats(const std::string& name) const {
     std::cout << "--- " << name << " Cache Stats ---\n";
@@ -70,5 +473,29 @@ void Cache::print_stats(const std::string& name) const {
                   << (double)hits / total << "\n";
     }
 
+    if (writes > 0 || writebacks > 0) {
+        std::cout << "Reads: " << reads << ", Writes: " << writes << "\n";
+        std::cout << "Writebacks: " << writebacks
+                  << " (" << writeback_bytes << " bytes)\n";
+        if (write_throughs > 0)
+            std::cout << "Write-through stores: " << write_throughs << "\n";
+    }
+
+    if (victim_fills > 0)
+        std::cout << "Victim fills: " << victim_fills << "\n";
+    if (back_invalidations > 0)
+        std::cout << "Back-invalidated lines: " << back_invalidations << "\n";
+
+    if (prefetcher) {
+        std::cout << "Prefetcher: " << prefetcher_type_name(prefetcher->get_type())
+                  << " (degree " << prefetcher->get_degree()
+                  << ", distance " << prefetcher->get_distance() << ")\n";
+        std::cout << "Prefetches issued: " << prefetch.issued
+                  << ", useful: " << prefetch.useful
+                  << ", late: " << prefetch.late
+                  << ", unused: " << prefetch.unused
+                  << ", polluting: " << prefetch.polluting << "\n";
+    }
+
     std::cout << "Average Memory Access Time: " << amat() << " cycles\n";
 }
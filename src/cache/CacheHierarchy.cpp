@@ -0,0 +1,226 @@
+#include "cache/CacheHierarchy.h"
+#include <iostream>
+
+CacheHierarchy::CacheHierarchy(InclusionPolicy policy, size_t dram)
+    : inclusion(policy),
+      dram_latency(dram),
+      memory_model(nullptr) {}
+
+bool CacheHierarchy::add_level(const std::string& name,
+                               size_t cache_size,
+                               size_t block_size,
+                               size_t associativity,
+                               const std::string& policy,
+                               size_t latency,
+                               WritePolicy write_policy,
+                               WriteMissPolicy write_miss_policy) {
+    if (!levels.empty()) {
+        size_t above = levels.back()->get_block_size();
+        if (block_size < above
+            || (inclusion == InclusionPolicy::EXCLUSIVE && block_size != above)) {
+            std::cerr << "Cannot add " << name << ": block size " << block_size
+                      << " does not fit below " << above << "-byte blocks\n";
+            return false;
+        }
+    }
+
+    std::unique_ptr<Cache> cache(new Cache(cache_size, block_size, associativity, policy));
+    cache->set_latency(latency);
+    cache->set_memory_latency(dram_latency);
+    cache->set_memory_model(memory_model);
+    cache->set_inclusion(inclusion);
+    cache->set_write_policy(write_policy, write_miss_policy);
+
+    if (!levels.empty())
+        levels.back()->set_next_level(cache.get());
+
+    levels.push_back(std::move(cache));
+    names.push_back(name);
+    return true;
+}
+
+bool CacheHierarchy::set_inclusion(InclusionPolicy policy) {
+    if (bus && policy == InclusionPolicy::EXCLUSIVE) {
+        std::cerr << "An exclusive hierarchy cannot have private caches per core\n";
+        return false;
+    }
+
+    inclusion = policy;
+    for (auto& cache : levels) {
+        cache->set_inclusion(policy);
+        cache->reset();
+    }
+    for (auto& cache : core_caches)
+        cache->reset();
+    if (bus)
+        bus->reset();
+    return true;
+}
+
+InclusionPolicy CacheHierarchy::get_inclusion() const {
+    return inclusion;
+}
+
+void CacheHierarchy::set_write_policy(size_t index, WritePolicy policy, WriteMissPolicy miss_policy) {
+    levels[index]->set_write_policy(policy, miss_policy);
+    if (index == 0) {
+        for (auto& cache : core_caches)
+            cache->set_write_policy(policy, miss_policy);
+    }
+
+    for (auto& cache : levels)
+        cache->reset();
+    for (auto& cache : core_caches)
+        cache->reset();
+    if (bus)
+        bus->reset();
+}
+
+bool CacheHierarchy::set_cores(size_t cores) {
+    if (cores == 0 || cores > CoherenceBus::MAX_CORES) {
+        std::cerr << "Core count must be between 1 and " << CoherenceBus::MAX_CORES << "\n";
+        return false;
+    }
+    if (cores > 1 && (levels.size() < 2 || inclusion == InclusionPolicy::EXCLUSIVE)) {
+        std::cerr << "Private caches per core need a shared, non-exclusive level below L1\n";
+        return false;
+    }
+
+    for (auto& cache : core_caches)
+        cache->set_next_level(nullptr);
+    core_caches.clear();
+    bus.reset();
+
+    if (!levels.empty())
+        levels.front()->set_coherent(cores > 1);
+
+    if (cores > 1) {
+        // Copies of the configured L1, each with a prefetcher of its own
+        std::vector<Cache*> l1s(1, levels.front().get());
+        for (size_t core = 1; core < cores; ++core) {
+            std::unique_ptr<Cache> copy(new Cache(*levels.front()));
+            copy->set_next_level(levels[1].get());
+            l1s.push_back(copy.get());
+            core_caches.push_back(std::move(copy));
+        }
+        bus.reset(new CoherenceBus(l1s, levels[1]->get_latency()));
+    }
+    copy_l1_prefetcher();
+
+    for (auto& cache : levels)
+        cache->reset();
+    for (auto& cache : core_caches)
+        cache->reset();
+    return true;
+}
+
+// A prefetcher trains on one core's misses, so the copies of L1 must not
+// share the one attached to core 0
+void CacheHierarchy::copy_l1_prefetcher() {
+    Prefetcher* prefetcher = levels.empty() ? nullptr : levels.front()->get_prefetcher();
+    core_prefetchers.clear();
+    for (auto& cache : core_caches) {
+        std::unique_ptr<Prefetcher> copy;
+        if (prefetcher)
+            copy.reset(new Prefetcher(prefetcher->get_type(), prefetcher->get_degree(),
+                                      prefetcher->get_distance()));
+        cache->set_prefetcher(copy.get());
+        core_prefetchers.push_back(std::move(copy));
+    }
+}
+
+void CacheHierarchy::set_prefetcher(size_t index, Prefetcher* prefetcher) {
+    levels[index]->set_prefetcher(prefetcher);
+    if (index == 0)
+        copy_l1_prefetcher();
+}
+
+size_t CacheHierarchy::num_cores() const {
+    return bus ? bus->num_cores() : 1;
+}
+
+// Only the last level reaches memory, but private L1 copies are made from
+// the first, so every level gets the model
+void CacheHierarchy::set_memory_model(MemoryLatencyModel* model) {
+    memory_model = model;
+    for (auto& cache : levels)
+        cache->set_memory_model(model);
+    for (auto& cache : core_caches)
+        cache->set_memory_model(model);
+}
+
+size_t CacheHierarchy::access(size_t address, AccessType type, size_t core) {
+    if (memory_model)
+        memory_model->set_core(core);
+    if (bus)
+        return bus->access(core, address, type);
+    if (levels.empty())
+        return memory_model ? memory_model->memory_latency(address) : dram_latency;
+    return levels.front()->access(address, type);
+}
+
+static size_t invalidate_lines(Cache& cache, size_t start, size_t size) {
+    size_t line = cache.get_block_size();
+    size_t cycles = 0;
+    for (size_t address = start / line * line; address < start + size; address += line)
+        cycles += cache.snoop_invalidate(address);
+    return cycles;
+}
+
+// Upper levels first, so their dirty lines are written into levels that
+// are then invalidated in turn
+size_t CacheHierarchy::invalidate_range(size_t start, size_t size) {
+    size_t cycles = 0;
+    for (auto& cache : core_caches)
+        cycles += invalidate_lines(*cache, start, size);
+    for (auto& cache : levels)
+        cycles += invalidate_lines(*cache, start, size);
+    return cycles;
+}
+
+size_t CacheHierarchy::num_levels() const {
+    return levels.size();
+}
+
+Cache& CacheHierarchy::level(size_t index) {
+    return *levels[index];
+}
+
+int CacheHierarchy::find_level(const std::string& name) const {
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (names[i] == name)
+            return (int)i;
+    }
+    return -1;
+}
+
+double CacheHierarchy::amat() const {
+    if (bus)
+        return bus->amat();
+    if (levels.empty())
+        return (double)dram_latency;
+    return levels.front()->amat();
+}
+
+void CacheHierarchy::print_stats() const {
+    if (bus) {
+        levels.front()->print_stats(names.front() + " core 0");
+        for (size_t i = 0; i < core_caches.size(); ++i)
+            core_caches[i]->print_stats(names.front() + " core " + std::to_string(i + 1));
+    }
+
+    for (size_t i = bus ? 1 : 0; i < levels.size(); ++i)
+        levels[i]->print_stats(names[i]);
+
+    if (bus)
+        bus->print_stats();
+
+    std::cout << "Global AMAT: " << amat() << " cycles ("
+              << inclusion_policy_name(inclusion) << " hierarchy, ";
+    if (bus)
+        std::cout << bus->num_cores() << " cores, ";
+    if (memory_model)
+        std::cout << "DRAM latency per memory node)\n";
+    else
+        std::cout << "DRAM latency " << dram_latency << " cycles)\n";
+}
@@ -1,59 +1,367 @@
 #include "cache/CacheSet.h"
 
-CacheSet::CacheSet(size_t associativity)
-    : lines(associativity) {
-            for (auto& line : lines) {
-        line.valid = false;
-        line.tag = 0;
-        line.last_used = 0;
-        line.inserted_at = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+void CacheArrays::init(size_t num_sets, size_t w, ReplacementPolicy policy, uint64_t seed) {
+    ways = w;
+    stride = (ways + CacheSet::SIMD_WAYS - 1) / CacheSet::SIMD_WAYS * CacheSet::SIMD_WAYS;
+
+    tags.assign(num_sets * stride, 0);
+    valid.assign(num_sets, 0);
+    dirty.assign(num_sets, 0);
+    prefetched.assign(num_sets, 0);
+    plru_leaves = 1;
+
+    switch (policy) {
+    case ReplacementPolicy::LRU:
+        last_used.assign(num_sets * stride, 0);
+        break;
+    case ReplacementPolicy::FIFO:
+        inserted_at.assign(num_sets * stride, 0);
+        break;
+    case ReplacementPolicy::PLRU:
+        plru_bits.assign(num_sets, 0);
+        while (plru_leaves < ways)
+            plru_leaves <<= 1;
+
+        // Point every node on the path to a way away from it
+        plru_touch_set.assign(ways, 0);
+        plru_touch_clear.assign(ways, 0);
+        for (size_t way = 0; way < ways; ++way) {
+            size_t node = 1, lo = 0, span = plru_leaves;
+            while (span > 1) {
+                span >>= 1;
+                if (way < lo + span) {
+                    plru_touch_set[way] |= 1ULL << node;
+                    node = node * 2;
+                } else {
+                    plru_touch_clear[way] |= 1ULL << node;
+                    lo += span;
+                    node = node * 2 + 1;
+                }
+            }
+        }
+        break;
+    case ReplacementPolicy::SRRIP:
+    case ReplacementPolicy::BRRIP:
+        rrpv_masks.assign(num_sets * (CacheSet::RRPV_MAX + 1), 0);
+        break;
+    case ReplacementPolicy::LFU:
+        last_used.assign(num_sets * stride, 0);
+        use_count.assign(num_sets * stride, 0);
+        heap.resize(num_sets * stride);
+        heap_pos.resize(num_sets * stride);
+        // All counts are zero, so the identity order is a valid heap
+        for (size_t s = 0; s < num_sets; ++s) {
+            for (size_t i = 0; i < stride; ++i) {
+                heap[s * stride + i] = (uint8_t)i;
+                heap_pos[s * stride + i] = (uint8_t)i;
+            }
+        }
+        break;
+    case ReplacementPolicy::RANDOM:
+        break;
+    }
+
+    rng_state = seed ? seed : 0x9e3779b97f4a7c15ULL;
+}
+
+// xorshift64*
+uint64_t CacheArrays::next_random() {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545f4914f6cdd1dULL;
+}
+
+CacheSet::CacheSet(CacheArrays& a, size_t s)
+    : arrays(a), set(s), base(s * a.stride) {}
+
+int CacheSet::find(uint64_t tag) const {
+    const uint64_t* tags = &arrays.tags[base];
+    uint64_t valid = arrays.valid[set];
+#if defined(__AVX2__)
+    __m256i needle = _mm256_set1_epi64x((long long)tag);
+    for (size_t w = 0; w < arrays.stride; w += 4) {
+        __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + w));
+        uint64_t mask = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(lanes, needle)));
+        uint64_t hit = (mask << w) & valid;
+        if (hit)
+            return __builtin_ctzll(hit);
+    }
+#elif defined(__SSE2__)
+    // No 64-bit compare in SSE2: both 32-bit halves have to match
+    __m128i needle = _mm_set1_epi64x((long long)tag);
+    for (size_t w = 0; w < arrays.stride; w += 2) {
+        __m128i lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + w));
+        __m128i eq32 = _mm_cmpeq_epi32(lanes, needle);
+        __m128i eq64 = _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+        uint64_t mask = (unsigned)_mm_movemask_pd(_mm_castsi128_pd(eq64));
+        uint64_t hit = (mask << w) & valid;
+        if (hit)
+            return __builtin_ctzll(hit);
+    }
+#else
+    for (size_t w = 0; w < arrays.ways; ++w) {
+        if (((valid >> w) & 1) && tags[w] == tag)
+            return (int)w;
+    }
+#endif
+    return -1;
+}
+
+// Tree-PLRU over the ways rounded up to a power of two. Node n's bit is
+// stored at bit n of the set's word (root is 1); a set bit means the
+// victim lies in the right subtree. Subtrees made only of padding ways are
+// never chosen.
+size_t CacheSet::plru_victim() const {
+    uint64_t bits = arrays.plru_bits[set];
+    size_t node = 1, lo = 0, span = arrays.plru_leaves;
+
+    while (span > 1) {
+        span >>= 1;
+        bool right = ((bits >> node) & 1) && lo + span < arrays.ways;
+        lo += right ? span : 0;
+        node = node * 2 + right;
     }
+    return lo;
+}
+
+// RRIP keeps one way mask per prediction value, so finding a distant line
+// and ageing the whole set are a handful of word operations
+size_t CacheSet::rrip_victim() {
+    uint64_t* masks = &arrays.rrpv_masks[set * (RRPV_MAX + 1)];
+
+    if (!masks[RRPV_MAX]) {
+        unsigned top = RRPV_MAX;
+        while (top > 0 && !masks[top])
+            top--;
+
+        // Age every line by the distance from the oldest to RRPV_MAX
+        unsigned shift = RRPV_MAX - top;
+        for (unsigned v = RRPV_MAX + 1; v-- > 0;)
+            masks[v] = v >= shift ? masks[v - shift] : 0;
     }
+    return __builtin_ctzll(masks[RRPV_MAX]);
+}
 
-    
+void CacheSet::rrip_set(size_t way, unsigned rrpv) {
+    uint64_t* masks = &arrays.rrpv_masks[set * (RRPV_MAX + 1)];
+    uint64_t bit = 1ULL << way;
+    for (unsigned v = 0; v <= RRPV_MAX; ++v)
+        masks[v] &= ~bit;
+    masks[rrpv] |= bit;
+}
+
+bool CacheSet::lfu_less(size_t a, size_t b) const {
+    uint32_t ca = arrays.use_count[base + a];
+    uint32_t cb = arrays.use_count[base + b];
+    if (ca != cb)
+        return ca < cb;
+    return arrays.last_used[base + a] < arrays.last_used[base + b];
+}
 
-bool CacheSet::access(size_t tag,
-                      const std::string& policy,
-                      size_t timestamp,
-                      bool& hit) {
+// Restores the heap after the key of the way at pos grew
+void CacheSet::lfu_sift_down(size_t pos) {
+    uint8_t* heap = &arrays.heap[base];
+    uint8_t* heap_pos = &arrays.heap_pos[base];
+    size_t n = arrays.ways;
 
-    //Checking for hit
-    for (auto& line : lines) {
-        if (line.valid && line.tag == tag) {
-            hit = true;
-            line.last_used = timestamp;
-            return true;
-        }
+    while (true) {
+        size_t smallest = pos;
+        size_t left = pos * 2 + 1;
+        size_t right = left + 1;
+        if (left < n && lfu_less(heap[left], heap[smallest]))
+            smallest = left;
+        if (right < n && lfu_less(heap[right], heap[smallest]))
+            smallest = right;
+        if (smallest == pos)
+            break;
+
+        uint8_t tmp = heap[pos];
+        heap[pos] = heap[smallest];
+        heap[smallest] = tmp;
+        heap_pos[heap[pos]] = (uint8_t)pos;
+        heap_pos[heap[smallest]] = (uint8_t)smallest;
+        pos = smallest;
     }
+}
 
-    //Miss
-    hit = false;
-    CacheLine* victim = nullptr;
+// Restores the heap after the key of the way at pos shrank
+void CacheSet::lfu_sift_up(size_t pos) {
+    uint8_t* heap = &arrays.heap[base];
+    uint8_t* heap_pos = &arrays.heap_pos[base];
 
-    // Prefer invalid line
-    for (auto& line : lines) {
-        if (!line.valid) {
-            victim = &line;
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (!lfu_less(heap[pos], heap[parent]))
             break;
-        }
+
+        uint8_t tmp = heap[pos];
+        heap[pos] = heap[parent];
+        heap[parent] = tmp;
+        heap_pos[heap[pos]] = (uint8_t)pos;
+        heap_pos[heap[parent]] = (uint8_t)parent;
+        pos = parent;
+    }
+}
+
+template <ReplacementPolicy Policy>
+int CacheSet::lookup(uint64_t tag, uint64_t timestamp) {
+    int way = find(tag);
+    if (way == -1)
+        return -1;
+
+    if (Policy == ReplacementPolicy::LRU) {
+        arrays.last_used[base + way] = timestamp;
+    } else if (Policy == ReplacementPolicy::PLRU) {
+        arrays.plru_bits[set] = (arrays.plru_bits[set] | arrays.plru_touch_set[way])
+                                & ~arrays.plru_touch_clear[way];
+    } else if (Policy == ReplacementPolicy::SRRIP || Policy == ReplacementPolicy::BRRIP) {
+        rrip_set(way, 0);
+    } else if (Policy == ReplacementPolicy::LFU) {
+        arrays.use_count[base + way]++;
+        arrays.last_used[base + way] = timestamp;
+        lfu_sift_down(arrays.heap_pos[base + way]);
     }
+    return way;
+}
+
+template <ReplacementPolicy Policy>
+int CacheSet::fill(uint64_t tag, uint64_t timestamp, bool dirty, CacheVictim& evicted) {
+    size_t ways = arrays.ways;
+
+    // Prefer an invalid line
+    uint64_t& valid = arrays.valid[set];
+    uint64_t all_ways = ways == 64 ? ~0ULL : (1ULL << ways) - 1;
+    uint64_t empty = ~valid & all_ways;
+    size_t victim;
 
-    //If no invalid line
-    if (!victim) {
-        victim = &lines[0];
-        for (auto& line : lines) {
-            if (policy == "LRU" && line.last_used < victim->last_used)
-                victim = &line;
-            else if (policy == "FIFO" && line.inserted_at < victim->inserted_at)
-                victim = &line;
+    if (Policy == ReplacementPolicy::LFU) {
+        // Invalid ways have a zero count and sit at the top of the heap
+        victim = arrays.heap[base];
+    } else if (empty) {
+        victim = __builtin_ctzll(empty);
+    } else if (Policy == ReplacementPolicy::LRU || Policy == ReplacementPolicy::FIFO) {
+        const uint64_t* age = Policy == ReplacementPolicy::LRU
+                              ? &arrays.last_used[base] : &arrays.inserted_at[base];
+        victim = 0;
+        uint64_t oldest = age[0];
+        for (size_t w = 1; w < ways; ++w) {
+            bool older = age[w] < oldest;
+            oldest = older ? age[w] : oldest;
+            victim = older ? w : victim;
         }
+    } else if (Policy == ReplacementPolicy::PLRU) {
+        victim = plru_victim();
+    } else if (Policy == ReplacementPolicy::SRRIP || Policy == ReplacementPolicy::BRRIP) {
+        victim = rrip_victim();
+    } else {
+        victim = arrays.next_random() % ways;
     }
 
+    uint64_t bit = 1ULL << victim;
+    uint64_t& dirty_bits = arrays.dirty[set];
+    evicted.tag = arrays.tags[base + victim];
+    evicted.valid = (valid & bit) != 0;
+    evicted.dirty = (valid & dirty_bits & bit) != 0;
+    evicted.prefetched = (valid & arrays.prefetched[set] & bit) != 0;
+
     // Replace victim
-    victim->tag = tag;
-    victim->valid = true;
-    victim->inserted_at = timestamp;
-    victim->last_used = timestamp;
+    arrays.tags[base + victim] = tag;
+    valid |= bit;
+    dirty_bits = dirty ? dirty_bits | bit : dirty_bits & ~bit;
+    arrays.prefetched[set] &= ~bit;
+
+    if (Policy == ReplacementPolicy::LRU) {
+        arrays.last_used[base + victim] = timestamp;
+    } else if (Policy == ReplacementPolicy::FIFO) {
+        arrays.inserted_at[base + victim] = timestamp;
+    } else if (Policy == ReplacementPolicy::PLRU) {
+        arrays.plru_bits[set] = (arrays.plru_bits[set] | arrays.plru_touch_set[victim])
+                                & ~arrays.plru_touch_clear[victim];
+    } else if (Policy == ReplacementPolicy::SRRIP) {
+        rrip_set(victim, RRPV_MAX - 1);
+    } else if (Policy == ReplacementPolicy::BRRIP) {
+        // Long re-reference interval except for one fill in 32
+        rrip_set(victim, arrays.next_random() % 32 ? RRPV_MAX : RRPV_MAX - 1);
+    } else if (Policy == ReplacementPolicy::LFU) {
+        arrays.use_count[base + victim] = 1;
+        arrays.last_used[base + victim] = timestamp;
+        lfu_sift_down(0);
+    }
+
+    return (int)victim;
+}
+
+void CacheSet::mark_dirty(int way) {
+    arrays.dirty[set] |= 1ULL << way;
+}
+
+bool CacheSet::is_dirty(int way) const {
+    return (arrays.dirty[set] >> way) & 1;
+}
+
+void CacheSet::clean(int way) {
+    arrays.dirty[set] &= ~(1ULL << way);
+}
+
+void CacheSet::touch(int way, uint64_t chunks, bool filled) {
+    uint64_t& t = arrays.touched[base + way];
+    t = filled ? chunks : t | chunks;
+}
+
+uint64_t CacheSet::touched(int way) const {
+    return arrays.touched[base + way];
+}
+
+void CacheSet::invalidate(int way, ReplacementPolicy policy) {
+    uint64_t bit = 1ULL << way;
+    arrays.valid[set] &= ~bit;
+    arrays.dirty[set] &= ~bit;
+    arrays.prefetched[set] &= ~bit;
 
-    return false;
+    if (policy == ReplacementPolicy::SRRIP || policy == ReplacementPolicy::BRRIP) {
+        uint64_t* masks = &arrays.rrpv_masks[set * (RRPV_MAX + 1)];
+        for (unsigned v = 0; v <= RRPV_MAX; ++v)
+            masks[v] &= ~bit;
+    } else if (policy == ReplacementPolicy::LFU) {
+        // Back to the top of the heap, ahead of every valid way
+        arrays.use_count[base + way] = 0;
+        arrays.last_used[base + way] = 0;
+        lfu_sift_up(arrays.heap_pos[base + way]);
+    }
+}
+
+void CacheSet::mark_prefetched(int way, uint64_t ready_at) {
+    arrays.prefetched[set] |= 1ULL << way;
+    arrays.prefetch_ready[base + way] = ready_at;
+}
+
+bool CacheSet::take_prefetched(int way, uint64_t& ready_at) {
+    uint64_t bit = 1ULL << way;
+    if (!(arrays.prefetched[set] & bit))
+        return false;
+
+    arrays.prefetched[set] &= ~bit;
+    ready_at = arrays.prefetch_ready[base + way];
+    return true;
 }
+
+template int CacheSet::lookup<ReplacementPolicy::LRU>(uint64_t, uint64_t);
+template int CacheSet::lookup<ReplacementPolicy::FIFO>(uint64_t, uint64_t);
+template int CacheSet::lookup<ReplacementPolicy::PLRU>(uint64_t, uint64_t);
+template int CacheSet::lookup<ReplacementPolicy::SRRIP>(uint64_t, uint64_t);
+template int CacheSet::lookup<ReplacementPolicy::BRRIP>(uint64_t, uint64_t);
+template int CacheSet::lookup<ReplacementPolicy::LFU>(uint64_t, uint64_t);
+template int CacheSet::lookup<ReplacementPolicy::RANDOM>(uint64_t, uint64_t);
+
+template int CacheSet::fill<ReplacementPolicy::LRU>(uint64_t, uint64_t, bool, CacheVictim&);
+template int CacheSet::fill<ReplacementPolicy::FIFO>(uint64_t, uint64_t, bool, CacheVictim&);
+template int CacheSet::fill<ReplacementPolicy::PLRU>(uint64_t, uint64_t, bool, CacheVictim&);
+template int CacheSet::fill<ReplacementPolicy::SRRIP>(uint64_t, uint64_t, bool, CacheVictim&);
+template int CacheSet::fill<ReplacementPolicy::BRRIP>(uint64_t, uint64_t, bool, CacheVictim&);
+template int CacheSet::fill<ReplacementPolicy::LFU>(uint64_t, uint64_t, bool, CacheVictim&);
+template int CacheSet::fill<ReplacementPolicy::RANDOM>(uint64_t, uint64_t, bool, CacheVictim&);
@@ -0,0 +1,205 @@
+#include "cache/CoherenceBus.h"
+#include <algorithm>
+#include <iostream>
+
+CoherenceBus::CoherenceBus(const std::vector<Cache*>& c, size_t latency)
+    : caches(c),
+      snoop_latency(latency),
+      block_size(c.empty() ? 1 : c.front()->get_block_size()) {
+
+    reset();
+}
+
+size_t CoherenceBus::num_cores() const {
+    return caches.size();
+}
+
+// Most contended first, lower addresses first among ties
+template <typename Entry>
+static bool more_contended(const Entry& a, const Entry& b) {
+    size_t ca = a.second.invalidations + a.second.interventions;
+    size_t cb = b.second.invalidations + b.second.interventions;
+    return ca != cb ? ca > cb : a.first < b.first;
+}
+
+void CoherenceBus::reset() {
+    stats = CoherenceStats();
+    lines.clear();
+    retired.clear();
+    total_accesses = 0;
+    total_cycles = 0;
+
+    // Held lines never outnumber the cache lines, so a sweep at least
+    // halves the map
+    size_t capacity = 0;
+    for (const Cache* cache : caches)
+        capacity += cache->get_num_sets() * cache->get_associativity();
+    sweep_at = std::max<size_t>(2 * capacity, 1);
+}
+
+// A retired line that is contended again takes its counts back
+CoherenceBus::LineContention& CoherenceBus::contention_of(uint64_t line) {
+    auto it = lines.find(line);
+    if (it != lines.end())
+        return it->second;
+
+    LineContention& contention = lines[line];
+    for (size_t i = 0; i < retired.size(); ++i) {
+        if (retired[i].first == line) {
+            contention = retired[i].second;
+            retired.erase(retired.begin() + i);
+            break;
+        }
+    }
+    return contention;
+}
+
+void CoherenceBus::drop_invalid_lines() {
+    for (auto it = lines.begin(); it != lines.end();) {
+        bool held = false;
+        for (Cache* cache : caches) {
+            bool dirty;
+            uint64_t touched;
+            if (cache->probe(it->first * block_size, dirty, touched)) {
+                held = true;
+                break;
+            }
+        }
+        if (held) {
+            ++it;
+            continue;
+        }
+
+        // Its copies are gone, so no later miss is a coherence miss
+        it->second.invalidated = 0;
+        retired.push_back(*it);
+        it = lines.erase(it);
+    }
+
+    std::sort(retired.begin(), retired.end(),
+              more_contended<std::pair<uint64_t, LineContention>>);
+    if (retired.size() > TOP_LINES)
+        retired.resize(TOP_LINES);
+}
+
+size_t CoherenceBus::access(size_t core, size_t address, AccessType type) {
+    total_accesses++;
+
+    Cache& self = *caches[core];
+    bool write = type == AccessType::WRITE;
+    uint64_t line = address / block_size;
+    uint64_t chunk = self.chunk_of(address);
+    uint64_t core_bit = 1ULL << core;
+
+    bool dirty;
+    uint64_t touched;
+    bool present = self.probe(address, dirty, touched);
+    size_t cycles = 0;
+
+    if (!present) {
+        if (write)
+            stats.bus_read_exclusives++;
+        else
+            stats.bus_reads++;
+
+        auto it = lines.find(line);
+        if (it != lines.end() && (it->second.invalidated & core_bit)) {
+            stats.coherence_misses++;
+            it->second.invalidated &= ~core_bit;
+        }
+    }
+
+    // Read hits need no transaction. Writes to a line held elsewhere
+    // invalidate the other copies; read misses make a Modified copy flush.
+    if (!present || write) {
+        bool shared = false;
+        bool waited = false;
+
+        for (size_t other = 0; other < caches.size(); ++other) {
+            bool other_dirty;
+            uint64_t other_touched;
+            if (other == core || !caches[other]->probe(address, other_dirty, other_touched))
+                continue;
+
+            shared = true;
+            if (!write && !other_dirty)
+                continue;
+
+            LineContention& contention = contention_of(line);
+            contention.cores |= core_bit | (1ULL << other);
+            if (!(other_touched & chunk)) {
+                contention.false_sharing++;
+                stats.false_sharing++;
+            }
+
+            if (write) {
+                cycles += caches[other]->snoop_invalidate(address);
+                contention.invalidations++;
+                contention.invalidated |= 1ULL << other;
+                stats.invalidations++;
+            } else {
+                cycles += caches[other]->snoop_downgrade(address);
+                contention.interventions++;
+                stats.interventions++;
+            }
+            waited = true;
+        }
+
+        // Shared -> Modified; Exclusive -> Modified is silent
+        if (present && shared)
+            stats.bus_upgrades++;
+        if (waited)
+            cycles += snoop_latency;
+    }
+
+    cycles += self.access(address, type);
+    total_cycles += cycles;
+
+    if (lines.size() >= sweep_at)
+        drop_invalid_lines();
+    return cycles;
+}
+
+double CoherenceBus::amat() const {
+    if (total_accesses == 0) return 0.0;
+    return (double)total_cycles / total_accesses;
+}
+
+const CoherenceStats& CoherenceBus::get_stats() const {
+    return stats;
+}
+
+void CoherenceBus::print_stats() const {
+    std::cout << "--- Coherence Stats (MESI, " << caches.size() << " cores) ---\n";
+    std::cout << "Bus reads: " << stats.bus_reads
+              << ", read-exclusive: " << stats.bus_read_exclusives
+              << ", upgrades: " << stats.bus_upgrades << "\n";
+    std::cout << "Invalidations: " << stats.invalidations << "\n";
+    std::cout << "Interventions: " << stats.interventions << "\n";
+    std::cout << "Coherence misses: " << stats.coherence_misses << "\n";
+    std::cout << "False sharing: " << stats.false_sharing << "\n";
+
+    if (lines.empty() && retired.empty())
+        return;
+
+    std::vector<std::pair<uint64_t, LineContention>> ranked(lines.begin(), lines.end());
+    ranked.insert(ranked.end(), retired.begin(), retired.end());
+    std::sort(ranked.begin(), ranked.end(),
+              more_contended<std::pair<uint64_t, LineContention>>);
+    if (ranked.size() > TOP_LINES)
+        ranked.resize(TOP_LINES);
+
+    std::cout << "Most contended lines:\n";
+    for (const auto& entry : ranked) {
+        const LineContention& c = entry.second;
+        std::cout << "  Address " << entry.first * block_size
+                  << ": invalidations " << c.invalidations
+                  << ", interventions " << c.interventions
+                  << ", false sharing " << c.false_sharing << ", cores";
+        for (size_t core = 0; core < caches.size(); ++core) {
+            if (c.cores & (1ULL << core))
+                std::cout << " " << core;
+        }
+        std::cout << "\n";
+    }
+}
@@ -0,0 +1,22 @@
+#include "cache/InclusionPolicy.h"
+
+bool parse_inclusion_policy(const std::string& name, InclusionPolicy& policy) {
+    if (name == "inclusive")
+        policy = InclusionPolicy::INCLUSIVE;
+    else if (name == "exclusive")
+        policy = InclusionPolicy::EXCLUSIVE;
+    else if (name == "nine")
+        policy = InclusionPolicy::NINE;
+    else
+        return false;
+    return true;
+}
+
+const char* inclusion_policy_name(InclusionPolicy policy) {
+    switch (policy) {
+    case InclusionPolicy::INCLUSIVE: return "inclusive";
+    case InclusionPolicy::EXCLUSIVE: return "exclusive";
+    case InclusionPolicy::NINE:      return "nine";
+    }
+    return "?";
+}
@@ -0,0 +1,171 @@
+#include "cache/Prefetcher.h"
+
+bool parse_prefetcher_type(const std::string& name, PrefetcherType& type) {
+    if (name == "next-line")
+        type = PrefetcherType::NEXT_LINE;
+    else if (name == "stride")
+        type = PrefetcherType::STRIDE;
+    else if (name == "stream")
+        type = PrefetcherType::STREAM;
+    else
+        return false;
+    return true;
+}
+
+const char* prefetcher_type_name(PrefetcherType type) {
+    switch (type) {
+    case PrefetcherType::NEXT_LINE: return "next-line";
+    case PrefetcherType::STRIDE:    return "stride";
+    case PrefetcherType::STREAM:    return "stream";
+    }
+    return "?";
+}
+
+Prefetcher::Prefetcher(PrefetcherType t, size_t deg, size_t dist)
+    : type(t),
+      degree(deg),
+      distance(dist ? dist : 1),
+      last_miss(0),
+      timestamp(0) {
+
+    if (type == PrefetcherType::STRIDE)
+        stride_table.assign(STRIDE_ENTRIES, StrideEntry());
+    else if (type == PrefetcherType::STREAM)
+        streams.assign(STREAMS, Stream());
+}
+
+void Prefetcher::observe(uint64_t line, PrefetchTrigger trigger, std::vector<uint64_t>& out) {
+    timestamp++;
+
+    switch (type) {
+    case PrefetcherType::NEXT_LINE:
+        next_line(line, trigger, out);
+        break;
+    case PrefetcherType::STRIDE:
+        stride(line, out);
+        break;
+    case PrefetcherType::STREAM:
+        stream(line, trigger, out);
+        break;
+    }
+}
+
+// Tagged next-line: misses and first uses of prefetched lines trigger, so
+// a sequential stream keeps the prefetcher running ahead of it
+void Prefetcher::next_line(uint64_t line, PrefetchTrigger trigger, std::vector<uint64_t>& out) {
+    if (trigger == PrefetchTrigger::HIT)
+        return;
+
+    for (size_t i = 0; i < degree; ++i)
+        out.push_back(line + distance + i);
+}
+
+// Trains on every access. An entry predicts once the same stride between
+// consecutive lines of its region has been seen STRIDE_CONFIDENT times.
+void Prefetcher::stride(uint64_t line, std::vector<uint64_t>& out) {
+    uint64_t region = line / REGION_LINES;
+    // Hashed so that regions a power of two apart do not share an entry
+    StrideEntry& entry = stride_table[(region * 0x9e3779b97f4a7c15ULL >> 32) % STRIDE_ENTRIES];
+
+    if (!entry.valid || entry.region != region) {
+        entry.region = region;
+        entry.last_line = line;
+        entry.stride = 0;
+        entry.confidence = 0;
+        entry.valid = true;
+        return;
+    }
+
+    int64_t delta = (int64_t)(line - entry.last_line);
+    if (delta == 0)
+        return;
+
+    if (delta == entry.stride) {
+        if (entry.confidence < 3)
+            entry.confidence++;
+    } else {
+        entry.stride = delta;
+        entry.confidence = 0;
+    }
+    entry.last_line = line;
+
+    if (entry.confidence < STRIDE_CONFIDENT)
+        return;
+
+    for (size_t i = 0; i < degree; ++i) {
+        int64_t target = (int64_t)line + entry.stride * (int64_t)(distance + i);
+        if (target >= 0)
+            out.push_back((uint64_t)target);
+    }
+}
+
+// A stream covers the lines from a miss up to its head, the last line it
+// prefetched. Demand misses or prefetch hits inside that window move the
+// head on to distance + degree - 1 lines past the demand line, at most
+// degree lines per trigger. Other misses start a new stream.
+void Prefetcher::stream(uint64_t line, PrefetchTrigger trigger, std::vector<uint64_t>& out) {
+    if (trigger == PrefetchTrigger::HIT)
+        return;
+
+    int64_t window = (int64_t)(distance + degree);
+    Stream* match = nullptr;
+
+    for (Stream& s : streams) {
+        if (!s.valid)
+            continue;
+        int64_t behind = ((int64_t)s.head - (int64_t)line) * s.direction;
+        if (behind >= -1 && behind < window) {
+            match = &s;
+            break;
+        }
+    }
+
+    if (!match) {
+        if (trigger != PrefetchTrigger::MISS)
+            return;
+
+        match = &streams[0];
+        for (Stream& s : streams) {
+            if (!s.valid) {
+                match = &s;
+                break;
+            }
+            if (s.last_used < match->last_used)
+                match = &s;
+        }
+
+        match->valid = true;
+        match->head = line;
+        match->direction = line + 1 == last_miss ? -1 : 1;
+    }
+
+    if (trigger == PrefetchTrigger::MISS)
+        last_miss = line;
+    match->last_used = timestamp;
+
+    // A miss just past the head means the stream fell behind
+    int64_t dir = match->direction;
+    if (((int64_t)line - (int64_t)match->head) * dir > 0)
+        match->head = line;
+
+    int64_t target = (int64_t)line + dir * (window - 1);
+    for (size_t n = 0; n < degree && ((target - (int64_t)match->head) * dir > 0); ++n) {
+        int64_t next = (int64_t)match->head + dir;
+        if (next < 0)
+            break;
+        match->head = (uint64_t)next;
+        out.push_back(match->head);
+    }
+}
+
+PrefetcherType Prefetcher::get_type() const {
+    return type;
+}
+
+size_t Prefetcher::get_degree() const {
+    return degree;
+}
+
+size_t Prefetcher::get_distance() const {
+    return distance;
+}
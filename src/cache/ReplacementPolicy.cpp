@@ -0,0 +1,34 @@
+#include "cache/ReplacementPolicy.h"
+
+bool parse_replacement_policy(const std::string& name, ReplacementPolicy& policy) {
+    if (name == "LRU")
+        policy = ReplacementPolicy::LRU;
+    else if (name == "FIFO")
+        policy = ReplacementPolicy::FIFO;
+    else if (name == "PLRU")
+        policy = ReplacementPolicy::PLRU;
+    else if (name == "SRRIP")
+        policy = ReplacementPolicy::SRRIP;
+    else if (name == "BRRIP")
+        policy = ReplacementPolicy::BRRIP;
+    else if (name == "LFU")
+        policy = ReplacementPolicy::LFU;
+    else if (name == "RANDOM")
+        policy = ReplacementPolicy::RANDOM;
+    else
+        return false;
+    return true;
+}
+
+const char* replacement_policy_name(ReplacementPolicy policy) {
+    switch (policy) {
+    case ReplacementPolicy::LRU:    return "LRU";
+    case ReplacementPolicy::FIFO:   return "FIFO";
+    case ReplacementPolicy::PLRU:   return "PLRU";
+    case ReplacementPolicy::SRRIP:  return "SRRIP";
+    case ReplacementPolicy::BRRIP:  return "BRRIP";
+    case ReplacementPolicy::LFU:    return "LFU";
+    case ReplacementPolicy::RANDOM: return "RANDOM";
+    }
+    return "?";
+}
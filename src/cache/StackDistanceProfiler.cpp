@@ -0,0 +1,173 @@
+#include "cache/StackDistanceProfiler.h"
+#include <iostream>
+
+StackDistanceProfiler::StackDistanceProfiler(size_t bsize, const std::vector<size_t>& set_counts)
+    : block_size(bsize) {
+
+    for (size_t num_sets : set_counts) {
+        Geometry g;
+        g.num_sets = num_sets ? num_sets : 1;
+        geometries.push_back(g);
+    }
+    reset();
+}
+
+void StackDistanceProfiler::reset() {
+    for (Geometry& g : geometries) {
+        g.sets.assign(g.num_sets, Stack());
+        for (Stack& s : g.sets) {
+            s.clock = 0;
+            s.live = 0;
+        }
+        g.histogram.clear();
+        g.cold = 0;
+    }
+    slots.clear();
+    last_time.clear();
+    accesses = 0;
+}
+
+// Marks at times [0, end)
+uint32_t StackDistanceProfiler::prefix(const Stack& s, uint32_t end) {
+    uint32_t sum = 0;
+    for (uint32_t i = end; i > 0; i -= i & (0 - i))
+        sum += s.tree[i];
+    return sum;
+}
+
+void StackDistanceProfiler::add(Stack& s, uint32_t time, int delta) {
+    for (uint32_t i = time + 1; i < s.tree.size(); i += i & (0 - i))
+        s.tree[i] += delta;
+}
+
+// Renumbers the resident lines of a set 0, 1, ... in access order and
+// rebuilds its tree with room for as many new accesses
+void StackDistanceProfiler::compact(Stack& s, size_t geometry) {
+    uint32_t capacity = 2 * (s.live + 1);
+    if (capacity < MIN_STACK)
+        capacity = MIN_STACK;
+    std::vector<uint32_t> owner(capacity, (uint32_t)NO_SLOT);
+    size_t stride = geometries.size();
+
+    uint32_t time = 0;
+    for (uint32_t old = 0; old < s.clock; ++old) {
+        uint32_t slot = s.owner[old];
+        if (slot == NO_SLOT)
+            continue;
+        owner[time] = slot;
+        last_time[slot * stride + geometry] = time + 1;
+        time++;
+    }
+
+    s.owner.swap(owner);
+    s.clock = time;
+
+    // Linear-time build: set the leaves, then push each node into its parent
+    s.tree.assign(capacity + 1, 0);
+    for (uint32_t i = 1; i <= time; ++i)
+        s.tree[i] = 1;
+    for (uint32_t i = 1; i <= capacity; ++i) {
+        uint32_t parent = i + (i & (0 - i));
+        if (parent <= capacity)
+            s.tree[parent] += s.tree[i];
+    }
+}
+
+void StackDistanceProfiler::access(size_t address) {
+    accesses++;
+
+    uint64_t line = address / block_size;
+    size_t stride = geometries.size();
+    auto inserted = slots.emplace(line, (uint32_t)slots.size());
+    uint32_t slot = inserted.first->second;
+    if (inserted.second)
+        last_time.resize(last_time.size() + stride, 0);
+
+    for (size_t g = 0; g < stride; ++g) {
+        Geometry& geo = geometries[g];
+        Stack& s = geo.sets[line % geo.num_sets];
+        if (s.clock == s.owner.size())
+            compact(s, g);
+
+        uint32_t& last = last_time[slot * stride + g];
+        if (last) {
+            uint32_t distance = prefix(s, s.clock) - prefix(s, last);
+            if (distance >= geo.histogram.size())
+                geo.histogram.resize(distance + 1, 0);
+            geo.histogram[distance]++;
+
+            add(s, last - 1, -1);
+            s.owner[last - 1] = NO_SLOT;
+        } else {
+            geo.cold++;
+            s.live++;
+        }
+
+        add(s, s.clock, 1);
+        s.owner[s.clock] = slot;
+        last = ++s.clock;
+    }
+}
+
+uint64_t StackDistanceProfiler::total_accesses() const {
+    return accesses;
+}
+
+size_t StackDistanceProfiler::distinct_lines() const {
+    return slots.size();
+}
+
+uint64_t StackDistanceProfiler::misses(const Geometry& g, size_t ways) {
+    uint64_t total = g.cold;
+    for (size_t d = ways; d < g.histogram.size(); ++d)
+        total += g.histogram[d];
+    return total;
+}
+
+double StackDistanceProfiler::miss_ratio(size_t num_sets, size_t ways) const {
+    for (const Geometry& g : geometries) {
+        if (g.num_sets != num_sets)
+            continue;
+        if (accesses == 0) return 0.0;
+        return (double)misses(g, ways) / accesses;
+    }
+    return -1.0;
+}
+
+bool StackDistanceProfiler::distance_histogram(size_t num_sets, std::vector<uint64_t>& histogram,
+                                               uint64_t& cold) const {
+    for (const Geometry& g : geometries) {
+        if (g.num_sets != num_sets)
+            continue;
+        histogram = g.histogram;
+        cold = g.cold;
+        return true;
+    }
+    return false;
+}
+
+void StackDistanceProfiler::print_stats() const {
+    std::cout << "--- Stack Distance Profile ---\n";
+    std::cout << "Accesses: " << accesses << ", distinct lines: " << slots.size()
+              << " (" << block_size << "-byte lines)\n";
+    if (accesses == 0)
+        return;
+
+    for (const Geometry& g : geometries) {
+        if (g.num_sets == 1)
+            std::cout << "Fully associative LRU miss ratios:\n";
+        else
+            std::cout << "LRU miss ratios with " << g.num_sets << " sets:\n";
+
+        // Ways past the largest distance only miss on first accesses
+        size_t ways = 1;
+        while (true) {
+            std::cout << "  " << g.num_sets * ways * block_size << " bytes, " << ways
+                      << (ways == 1 ? " way: " : " ways: ")
+                      << (double)misses(g, ways) / accesses << "\n";
+            if (ways >= g.histogram.size())
+                break;
+            ways *= 2;
+        }
+    }
+}
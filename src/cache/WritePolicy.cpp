@@ -0,0 +1,21 @@
+#include "cache/WritePolicy.h"
+
+bool parse_write_policy(const std::string& name, WritePolicy& policy) {
+    if (name == "write-back")
+        policy = WritePolicy::WRITE_BACK;
+    else if (name == "write-through")
+        policy = WritePolicy::WRITE_THROUGH;
+    else
+        return false;
+    return true;
+}
+
+bool parse_write_miss_policy(const std::string& name, WriteMissPolicy& policy) {
+    if (name == "write-allocate")
+        policy = WriteMissPolicy::WRITE_ALLOCATE;
+    else if (name == "no-write-allocate")
+        policy = WriteMissPolicy::NO_WRITE_ALLOCATE;
+    else
+        return false;
+    return true;
+}
@@ -1,29 +1,337 @@
+#include "ConcurrentAllocator.h"
 #include "MemoryManager.h"
-#include "cache/Cache.h"
+#include "SlabAllocator.h"
+#include "cache/CacheHierarchy.h"
 #include "vm/VirtualMemoryManager.h"
+#include "trace/BinaryTrace.h"
+#include "trace/SimulatorConfig.h"
+#include "trace/Sweep.h"
+#include "trace/TextTraceReader.h"
+#include "trace/TextTraceWriter.h"
+#include "trace/TraceReplayer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_set>
 
 
-int main() {
+template <typename Reader>
+static double replay_records(Reader& reader, TraceReplayer& replayer) {
+    TraceRecord record;
+
+    auto begin = std::chrono::steady_clock::now();
+    while (reader.next(record))
+        replayer.apply(record);
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+// Batch mode: replay a text or binary trace file without prompts or
+// per-command output and print aggregate statistics once at the end.
+static int replay_trace(const std::string& path,
+                        MemoryManager& mm,
+                        SlabAllocator& slab,
+                        VirtualMemoryManager& vmm,
+                        CacheHierarchy& caches,
+                        const StackDistanceProfiler* profiler,
+                        const WorkingSetTracker* working_set) {
+    TraceReplayer replayer(mm, slab, vmm);
+    SimulatorConfig config(caches, vmm, nullptr);
+    replayer.set_config(&config);
+    BinaryTraceReader binary;
+    TextTraceReader text;
+
+    if (binary.open(path)) {
+        replayer.print_summary(replay_records(binary, replayer));
+        std::cout << "Format: binary" << (binary.is_compressed() ? ", block-compressed" : "")
+                  << (binary.is_corrupt() ? " (stopped at corrupt data)" : "") << "\n";
+    } else if (text.open(path)) {
+        replayer.print_summary(replay_records(text, replayer));
+        std::cout << "Lines: " << text.lines_read()
+                  << " (output-only commands skipped: " << text.skipped_lines()
+                  << ", unsupported: " << text.unsupported_lines()
+                  << ", malformed: " << text.malformed_lines() << ")\n";
+    } else {
+        std::cerr << "Cannot open trace " << path << "\n";
+        return 1;
+    }
+
+    if (replayer.is_initialized()) {
+        mm.print_stats();
+        slab.print_stats();
+    }
+    caches.print_stats();
+    if (profiler)
+        profiler->print_stats();
+    vmm.print_stats();
+    if (working_set)
+        working_set->print_stats();
+    return 0;
+}
+
+template <typename Reader>
+static void collect_accesses(Reader& reader, std::vector<size_t>& addresses) {
+    TraceRecord record;
+    while (reader.next(record)) {
+        if (record.op == TraceOp::ACCESS || record.op == TraceOp::READ ||
+            record.op == TraceOp::WRITE)
+            addresses.push_back(record.value);
+    }
+}
+
+// Gives OPT the virtual addresses the trace will access, with a first
+// pass over the file
+static void load_future(const std::string& path, VirtualMemoryManager& vmm) {
+    BinaryTraceReader binary;
+    TextTraceReader text;
+    std::vector<size_t> addresses;
+
+    if (binary.open(path))
+        collect_accesses(binary, addresses);
+    else if (text.open(path))
+        collect_accesses(text, addresses);
+    vmm.set_future(addresses);
+}
+
+// Profiles the given set counts, or by default fully associative caches
+// and the set counts of the hierarchy's levels, at L1's line size
+static StackDistanceProfiler* make_profiler(CacheHierarchy& caches, std::vector<size_t> sets) {
+    if (sets.empty()) {
+        sets.push_back(1);
+        for (size_t i = 0; i < caches.num_levels(); ++i) {
+            size_t n = caches.level(i).get_num_sets();
+            if (std::find(sets.begin(), sets.end(), n) == sets.end())
+                sets.push_back(n);
+        }
+    }
+
+    size_t block = caches.num_levels() ? caches.level(0).get_block_size() : 64;
+    return new StackDistanceProfiler(block, sets);
+}
+
+static bool is_json_path(const std::string& path) {
+    return path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+}
+
+// Writes the working set time series: JSON, with the reuse distance
+// histogram, if the path ends in ".json", otherwise CSV
+static bool export_working_set(const WorkingSetTracker& tracker, const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Cannot write " << path << "\n";
+        return false;
+    }
+
+    if (is_json_path(path))
+        tracker.write_json(out);
+    else
+        tracker.write_csv(out);
+    return true;
+}
+
+// Writes the fragmentation samples as JSON or CSV, like export_working_set
+static bool export_fragmentation(const MemoryManager& mm, const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Cannot write " << path << "\n";
+        return false;
+    }
+
+    if (is_json_path(path))
+        mm.write_fragmentation_json(out);
+    else
+        mm.write_fragmentation_csv(out);
+    return true;
+}
+
+// Converts text traces to the binary format and binary traces back to text.
+static int convert_trace(const std::string& in_path,
+                         const std::string& out_path,
+                         bool compress) {
+    BinaryTraceReader binary;
+    TextTraceReader text;
+    TraceRecord record;
+    size_t records = 0;
+    bool ok;
+
+    if (binary.open(in_path)) {
+        TextTraceWriter writer;
+        if (!writer.open(out_path)) {
+            std::cerr << "Cannot write " << out_path << "\n";
+            return 1;
+        }
+        while (binary.next(record)) {
+            writer.write(record);
+            records++;
+        }
+        ok = writer.close() && !binary.is_corrupt();
+    } else if (text.open(in_path)) {
+        BinaryTraceWriter writer;
+        if (!writer.open(out_path, compress)) {
+            std::cerr << "Cannot write " << out_path << "\n";
+            return 1;
+        }
+        while (text.next(record)) {
+            writer.write(record);
+            records++;
+        }
+        ok = writer.close();
+        if (text.unsupported_lines())
+            std::cerr << "Dropped " << text.unsupported_lines() << " unsupported commands\n";
+        if (text.malformed_lines())
+            std::cerr << "Dropped " << text.malformed_lines() << " malformed lines\n";
+    } else {
+        std::cerr << "Cannot open trace " << in_path << "\n";
+        return 1;
+    }
+
+    std::cout << "Converted " << records << " records to " << out_path << "\n";
+    return ok ? 0 : 1;
+}
+
+// Replays one trace through every configuration of a grid file and
+// writes a table of the results: JSON if the output ends in ".json",
+// otherwise CSV (to stdout without an output file).
+static int sweep(int argc, char* argv[]) {
+    size_t threads = 0;
+    std::string out_path;
+    for (int i = 4; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag == "--threads")
+            threads = std::strtoul(argv[i + 1], nullptr, 10);
+        else if (flag == "--out")
+            out_path = argv[i + 1];
+        else
+            return -1;
+    }
+
+    SweepGrid grid;
+    if (!grid.load(argv[3]))
+        return 1;
+
+    SweepRunner runner(grid, threads);
+    std::vector<SweepResult> results;
+
+    auto begin = std::chrono::steady_clock::now();
+    if (!runner.run(argv[2], results))
+        return 1;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::ofstream file;
+    if (!out_path.empty()) {
+        file.open(out_path);
+        if (!file) {
+            std::cerr << "Cannot write " << out_path << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = out_path.empty() ? std::cout : file;
+
+    if (is_json_path(out_path))
+        SweepRunner::write_json(out, grid, results);
+    else
+        SweepRunner::write_csv(out, grid, results);
+
+    std::cerr << "Swept " << results.size() << " configurations on "
+              << std::min(runner.num_threads(), results.size()) << " threads in "
+              << seconds << " s\n";
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
     MemoryManager mm;
+    SlabAllocator slab(mm);
     bool initialized = false;
 
     std::string line;
 
-    std::cout << "Memory Management Simulator\n";
-    std::cout << "Type 'help' to see available commands\n";
-    std::cout << "Type 'exit' to quit\n";
+CacheHierarchy caches(InclusionPolicy::NINE, 100); // 100-cycle DRAM
+caches.add_level("L1", 256, 64, 2, "LRU", 1);      // 256B, 2-way, 1 cycle
+caches.add_level("L2", 1024, 64, 4, "LRU", 10);    // 1KB, 4-way, 10 cycles
+const size_t vm_memory = 1024;
+VirtualMemoryManager vmm(mm, caches, vm_memory, "LRU");
+
+std::unique_ptr<StackDistanceProfiler> profiler;
+std::unique_ptr<WorkingSetTracker> working_set;
+// Separate heap; each core allocates through a thread cache of its own
+std::unique_ptr<ConcurrentAllocator> concurrent;
+std::vector<std::unique_ptr<ConcurrentAllocator::ThreadCache>> thread_caches;
+std::unordered_set<size_t> concurrent_objects;
+SimulatorConfig config(caches, vmm, std::cout.rdbuf());
+
+    if (argc >= 3 && std::string(argv[1]) == "--replay") {
+        std::string working_set_path, fragmentation_path;
+        bool ok = true;
+        for (int i = 3; i < argc && ok; ++i) {
+            std::string flag = argv[i];
+            if (flag == "--cores" && i + 1 < argc)
+                ok = caches.set_cores(std::strtoul(argv[++i], nullptr, 10));
+            else if (flag == "--profile")
+                profiler.reset(make_profiler(caches, std::vector<size_t>()));
+            else if (flag == "--vm-policy" && i + 1 < argc) {
+                PageReplacementPolicy policy;
+                ok = parse_page_replacement_policy(argv[++i], policy);
+                if (ok)
+                    vmm.set_policy(policy);
+                if (ok && policy == PageReplacementPolicy::OPT)
+                    load_future(argv[2], vmm);
+            } else if (flag == "--working-set" && i + 1 < argc) {
+                working_set_path = argv[++i];
+                working_set.reset(new WorkingSetTracker(
+                    {1000, 10000, 100000}, WorkingSetTracker::DEFAULT_INTERVAL));
+            } else if (flag == "--compact-on-failure" && i + 1 < argc) {
+                mm.set_auto_compaction(true, std::strtoul(argv[++i], nullptr, 10));
+            } else if (flag == "--fragmentation" && i + 1 < argc) {
+                fragmentation_path = argv[++i];
+                mm.set_fragmentation_sampling(1);
+            } else
+                ok = false;
+        }
 
+        if (ok) {
+            vmm.set_profiler(profiler.get());
+            vmm.set_working_set_tracker(working_set.get());
+            int status = replay_trace(argv[2], mm, slab, vmm, caches, profiler.get(),
+                                      working_set.get());
+            if (status == 0 && working_set && !export_working_set(*working_set, working_set_path))
+                status = 1;
+            if (status == 0 && !fragmentation_path.empty() &&
+                !export_fragmentation(mm, fragmentation_path))
+                status = 1;
+            return status;
+        }
+    }
 
-Cache L2(1024, 64, 4, "LRU"); // 1KB, 4-way
-Cache L1(256, 64, 2, "LRU");  // 256B, 2-way
-VirtualMemoryManager vmm(mm, L1, 1024, "LRU");
+    if ((argc == 4 || argc == 5) && std::string(argv[1]) == "--convert") {
+        bool compress = argc == 5 && std::string(argv[4]) == "--compress";
+        if (argc == 4 || compress)
+            return convert_trace(argv[2], argv[3], compress);
+    }
 
-L1.set_next_level(&L2);
+    if (argc >= 4 && argc % 2 == 0 && std::string(argv[1]) == "--sweep") {
+        int status = sweep(argc, argv);
+        if (status != -1)
+            return status;
+    }
 
+    if (argc != 1) {
+        std::cerr << "Usage: " << argv[0] << " [--replay <trace> [--cores <n>] [--profile] [--vm-policy <policy>]\n"
+                  << "                 [--working-set <file.csv|file.json>] [--fragmentation <file.csv|file.json>]\n"
+                  << "                 [--compact-on-failure <step_bytes>]]\n"
+                  << "       " << argv[0] << " --convert <in> <out> [--compress]\n"
+                  << "       " << argv[0] << " --sweep <trace> <grid> [--threads <n>] [--out <file.csv|file.json>]\n";
+        return 1;
+    }
 
+    std::cout << "Memory Management Simulator\n";
+    std::cout << "Type 'help' to see available commands\n";
+    std::cout << "Type 'exit' to quit\n";
 
 
     while (true) {
@@ -42,13 +350,46 @@ L1.set_next_level(&L2);
         else if (cmd == "help") {
             std::cout << "Available commands:\n";
             std::cout << "  init <size>                  Initialize memory\n";
-            std::cout << "  alloc <first|best|worst> <size>  Allocate memory\n";
+            std::cout << "  alloc <first|best|worst|buddy> <size>  Allocate memory\n";
             std::cout << "  free <block_id>              Free allocated block\n";
+            std::cout << "  slab_alloc <size>            Allocate object from slab cache\n";
+            std::cout << "  slab_free <object_id>        Free slab object\n";
+            std::cout << "  slab_stats                   Show slab cache statistics\n";
+            std::cout << "  concurrent_init <size>       Start a thread-cached allocator with its own heap\n";
+            std::cout << "  concurrent_alloc <size>      Allocate through the current core's thread cache\n";
+            std::cout << "  concurrent_free <address>    Free through the current core's thread cache\n";
+            std::cout << "  concurrent_stats             Show thread cache and central list statistics\n";
+            std::cout << "  compact [max_bytes]          Slide allocated blocks together\n";
+            std::cout << "  compaction <on [step_bytes]|off>  Compact and retry when an allocation fails\n";
             std::cout << "  dump                          Show memory layout\n";
+            std::cout << "  fragmentation <on <interval>|off|export <file>>\n"
+                      << "                               Sample fragmentation every interval allocations\n";
             std::cout << "  stats                         Show memory statistics\n";
             std::cout << "  access <address>              Access memory address via cache\n";
+            std::cout << "  read <address>               Load from address (same as access)\n";
+            std::cout << "  write <address>              Store to address\n";
             std::cout << "  cache_stats                  Show cache statistics\n";
+            std::cout << "  inclusion <inclusive|exclusive|nine>  Set the L2 inclusion policy\n";
+            std::cout << "  write_policy <L1|L2> <write-back|write-through> <write-allocate|no-write-allocate>\n"
+                      << "                               Set the write policies of a cache level\n";
+            std::cout << "  prefetch <L1|L2> <none|next-line|stride|stream> [degree] [distance]\n"
+                      << "                               Attach a prefetcher to a cache level\n";
+            std::cout << "  profile <on|off|stats> [sets...]  Stack distance profile of all LRU sizes\n";
+            std::cout << "  cores <n>                    Give each of n cores a private L1\n";
+            std::cout << "  core <id>                    Issue the following accesses from a core\n";
+            std::cout << "  vm_policy <FIFO|LRU|CLOCK|SECOND_CHANCE|WSCLOCK> [window]\n"
+                      << "                               Set the page replacement policy\n";
+            std::cout << "  paging <levels> <page_size> [huge_page_size] [va_bits]  Rebuild the page table; walks go through the caches\n";
+            std::cout << "  tlb <entries> <ways> <policy> [<entries> <ways> <policy>] | tlb off\n"
+                      << "                               Give each core a one- or two-level TLB\n";
+            std::cout << "  numa <nodes> <local_latency> <remote_latency> | numa off\n"
+                      << "                               Split memory into NUMA nodes; cores are spread round robin\n";
+            std::cout << "  numa policy <first-touch|interleave|bind <node>>  Place new pages\n";
+            std::cout << "  numa migrate <threshold>     Move a page after threshold remote accesses in a row (0 is off)\n";
+            std::cout << "  numa latency <node> <local> <remote>  Set one node's memory latencies\n";
             std::cout << "  vm_stats                     Show virtual memory statistics\n";
+            std::cout << "  working_set <on <interval> [windows...]|off|stats|export <file>>\n"
+                      << "                               Track working set sizes, page reuse distances and fault rates\n";
             std::cout << "  exit                          Exit simulator\n";
 
         }   
@@ -64,6 +405,7 @@ L1.set_next_level(&L2);
             }
 
             mm.init(size);
+            slab.reset();
             initialized = true;
             std::cout << "Initialized memory with size " << size << "\n";
         }
@@ -79,7 +421,7 @@ L1.set_next_level(&L2);
             ss >> strategy >> size;
 
             if (!ss) {
-                std::cout << "Usage: alloc <first|best|worst> <size>\n";
+                std::cout << "Usage: alloc <first|best|worst|buddy> <size>\n";
                 continue;
             }
 
@@ -91,6 +433,8 @@ L1.set_next_level(&L2);
                 id = mm.allocate_best_fit(size);
             else if (strategy == "worst")
                 id = mm.allocate_worst_fit(size);
+            else if (strategy == "buddy")
+                id = mm.allocate_buddy(size);
             else {
                 std::cout << "Unknown strategy\n";
                 continue;
@@ -116,12 +460,176 @@ L1.set_next_level(&L2);
                 continue;
             }
 
-            if (mm.free_block(id))
+            if (slab.owns_block(id))
+                std::cout << "Block " << id << " holds a slab; free its objects with slab_free\n";
+            else if (mm.free_block(id))
                 std::cout << "Freed block " << id << "\n";
             else
                 std::cout << "Invalid block id\n";
         }
 
+        else if (cmd == "compact") {
+            if (!initialized) {
+                std::cout << "Memory not initialized\n";
+                continue;
+            }
+
+            size_t max_bytes = 0;
+            ss >> max_bytes;
+            size_t moved = mm.compact(max_bytes);
+            std::cout << "Moved " << moved << " bytes; largest free block is now "
+                      << mm.largest_free_block() << "\n";
+        }
+
+        else if (cmd == "compaction") {
+            std::string mode;
+            ss >> mode;
+
+            if (mode == "on") {
+                size_t step = 0;
+                ss >> step;
+                mm.set_auto_compaction(true, step);
+                std::cout << "Failed allocations now compact ";
+                if (step)
+                    std::cout << "up to " << step << " bytes and retry\n";
+                else
+                    std::cout << "the whole heap and retry\n";
+            } else if (mode == "off") {
+                mm.set_auto_compaction(false);
+                std::cout << "Automatic compaction off\n";
+            } else {
+                std::cout << "Usage: compaction <on [step_bytes]|off>\n";
+            }
+        }
+
+        else if (cmd == "slab_alloc") {
+            if (!initialized) {
+                std::cout << "Memory not initialized\n";
+                continue;
+            }
+
+            size_t size;
+            ss >> size;
+
+            if (!ss) {
+                std::cout << "Usage: slab_alloc <size>\n";
+                continue;
+            }
+
+            int id = slab.allocate(size);
+
+            if (id == -1)
+                std::cout << "Allocation failed\n";
+            else
+                std::cout << "Allocated object id " << id << "\n";
+        }
+
+        else if (cmd == "slab_free") {
+            if (!initialized) {
+                std::cout << "Memory not initialized\n";
+                continue;
+            }
+
+            int id;
+            ss >> id;
+
+            if (!ss) {
+                std::cout << "Usage: slab_free <object_id>\n";
+                continue;
+            }
+
+            if (slab.free(id))
+                std::cout << "Freed object " << id << "\n";
+            else
+                std::cout << "Invalid object id\n";
+        }
+
+        else if (cmd == "slab_stats") {
+            if (!initialized) {
+                std::cout << "Memory not initialized\n";
+                continue;
+            }
+
+            slab.print_stats();
+        }
+
+        else if (cmd == "concurrent_init") {
+            size_t size;
+            ss >> size;
+
+            if (!ss || size == 0) {
+                std::cout << "Usage: concurrent_init <size>\n";
+                continue;
+            }
+
+            // The caches flush into the allocator they belong to
+            thread_caches.clear();
+            concurrent_objects.clear();
+            concurrent.reset(new ConcurrentAllocator(size));
+            std::cout << "Concurrent allocator with a " << size << "-byte heap, "
+                      << concurrent->num_classes() << " size classes\n";
+        }
+
+        else if (cmd == "concurrent_alloc" || cmd == "concurrent_free") {
+            if (!concurrent) {
+                std::cout << "Concurrent allocator not initialized\n";
+                continue;
+            }
+
+            size_t value;
+            ss >> value;
+
+            if (!ss) {
+                std::cout << "Usage: " << cmd
+                          << (cmd == "concurrent_alloc" ? " <size>\n" : " <address>\n");
+                continue;
+            }
+
+            size_t core = vmm.get_core();
+            if (thread_caches.size() <= core)
+                thread_caches.resize(core + 1);
+            if (!thread_caches[core])
+                thread_caches[core].reset(new ConcurrentAllocator::ThreadCache(*concurrent));
+            ConcurrentAllocator::ThreadCache& cache = *thread_caches[core];
+
+            if (cmd == "concurrent_alloc") {
+                size_t address = cache.allocate(value);
+                if (address == ConcurrentAllocator::NO_ADDRESS) {
+                    std::cout << "Allocation failed\n";
+                    continue;
+                }
+                concurrent_objects.insert(address);
+                std::cout << "Allocated " << value << " bytes at address " << address
+                          << " (core " << core << ")\n";
+            } else {
+                if (!concurrent_objects.erase(value)) {
+                    std::cout << "Address " << value << " is not allocated\n";
+                    continue;
+                }
+                cache.free(value);
+                std::cout << "Freed address " << value << " (core " << core << ")\n";
+            }
+        }
+
+        else if (cmd == "concurrent_stats") {
+            if (!concurrent) {
+                std::cout << "Concurrent allocator not initialized\n";
+                continue;
+            }
+
+            for (size_t core = 0; core < thread_caches.size(); ++core) {
+                if (!thread_caches[core])
+                    continue;
+                ConcurrentAllocator::ThreadCache& cache = *thread_caches[core];
+                cache.merge_stats();
+                std::cout << "Core " << core << " thread cache hits: " << cache.get_hits()
+                          << ", misses: " << cache.get_misses() << ", batch transfers: "
+                          << cache.get_fetches() << " fetched, " << cache.get_releases()
+                          << " released, " << cache.cached_objects() << " objects cached\n";
+            }
+            concurrent->print_stats();
+        }
+
         else if (cmd == "dump") {
             if (!initialized) {
                 std::cout << "Memory not initialized\n";
@@ -152,10 +660,132 @@ L1.set_next_level(&L2);
             vmm.access(address);
         }
 
+        else if (cmd == "read" || cmd == "write") {
+            size_t address;
+            ss >> address;
+
+            if (!ss) {
+                std::cout << "Usage: " << cmd << " <virtual_address>\n";
+                continue;
+            }
+
+            vmm.access(address, cmd == "write" ? AccessType::WRITE : AccessType::READ);
+        }
+
 
         else if (cmd == "cache_stats") {
-            L1.print_stats("L1");
-            L2.print_stats("L2");
+            caches.print_stats();
+        }
+
+        else if (cmd == "fragmentation") {
+            std::string mode;
+            ss >> mode;
+
+            if (mode == "on") {
+                size_t interval = 0;
+                ss >> interval;
+                if (interval == 0) {
+                    std::cout << "Usage: fragmentation on <interval>\n";
+                    continue;
+                }
+                mm.set_fragmentation_sampling(interval);
+                std::cout << "Sampling fragmentation every " << interval << " allocations\n";
+            } else if (mode == "off") {
+                mm.set_fragmentation_sampling(0);
+                std::cout << "Fragmentation sampling stopped\n";
+            } else if (mode == "export") {
+                std::string path;
+                ss >> path;
+                if (path.empty())
+                    std::cout << "Usage: fragmentation export <file.csv|file.json>\n";
+                else if (export_fragmentation(mm, path))
+                    std::cout << "Wrote " << mm.num_fragmentation_samples() << " samples to " << path << "\n";
+            } else {
+                std::cout << "Usage: fragmentation <on <interval>|off|export <file>>\n";
+            }
+        }
+
+        else if (cmd == "working_set") {
+            std::string mode;
+            ss >> mode;
+
+            if (mode == "on") {
+                size_t interval = 0, window;
+                std::vector<size_t> windows;
+                ss >> interval;
+                while (ss >> window)
+                    windows.push_back(window);
+
+                if (interval == 0) {
+                    std::cout << "Usage: working_set on <interval> [windows...]\n";
+                    continue;
+                }
+                working_set.reset(new WorkingSetTracker(windows, interval));
+                vmm.set_working_set_tracker(working_set.get());
+                std::cout << "Tracking the working set every " << interval << " accesses\n";
+            } else if (mode == "off") {
+                vmm.set_working_set_tracker(nullptr);
+                working_set.reset();
+                std::cout << "Working set tracking stopped\n";
+            } else if ((mode == "stats" || mode == "export") && !working_set) {
+                std::cout << "Working set tracking is off\n";
+            } else if (mode == "stats") {
+                working_set->print_stats();
+            } else if (mode == "export") {
+                std::string path;
+                ss >> path;
+                if (path.empty())
+                    std::cout << "Usage: working_set export <file.csv|file.json>\n";
+                else if (export_working_set(*working_set, path))
+                    std::cout << "Wrote " << working_set->num_samples() << " samples to " << path << "\n";
+            } else {
+                std::cout << "Usage: working_set <on <interval> [windows...]|off|stats|export <file>>\n";
+            }
+        }
+
+        else if (cmd == "profile") {
+            std::string mode;
+            ss >> mode;
+
+            if (mode == "on") {
+                std::vector<size_t> sets;
+                size_t n;
+                while (ss >> n)
+                    sets.push_back(n);
+
+                profiler.reset(make_profiler(caches, sets));
+                vmm.set_profiler(profiler.get());
+                std::cout << "Profiling stack distances\n";
+            } else if (mode == "off") {
+                vmm.set_profiler(nullptr);
+                profiler.reset();
+                std::cout << "Profiling stopped\n";
+            } else if (mode == "stats" && profiler) {
+                profiler->print_stats();
+            } else if (mode == "stats") {
+                std::cout << "Profiling is off\n";
+            } else {
+                std::cout << "Usage: profile <on|off|stats> [sets...]\n";
+            }
+        }
+
+        else if (cmd == "core") {
+            size_t core;
+            ss >> core;
+
+            if (!ss) {
+                std::cout << "Usage: core <id>\n";
+                continue;
+            }
+
+            if (vmm.set_core(core))
+                std::cout << "Accesses now come from core " << core << "\n";
+            else
+                std::cout << "No core " << core << " (" << caches.num_cores() << " cores)\n";
+        }
+
+        else if (SimulatorConfig::is_command(cmd)) {
+            config.apply(line);
         }
 
         else if (cmd == "vm_stats") {
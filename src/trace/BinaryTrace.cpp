@@ -0,0 +1,298 @@
+#include "trace/BinaryTrace.h"
+#include <cstring>
+
+static const char MAGIC[4] = {'M', 'S', 'T', 'R'};
+static const size_t MIN_MATCH = 4;
+static const size_t HASH_BITS = 14;
+
+static inline void put_varint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+static inline bool get_varint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (p == end)
+            return false;
+        uint8_t byte = *p++;
+        v |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static inline uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+bool BinaryTraceFormat::is_binary_trace(const char* data, size_t size) {
+    return size >= HEADER_SIZE && std::memcmp(data, MAGIC, 4) == 0;
+}
+
+void BinaryTraceFormat::write_header(uint8_t* out, bool compressed) {
+    std::memcpy(out, MAGIC, 4);
+    out[4] = VERSION;
+    out[5] = compressed ? FLAG_COMPRESSED : 0;
+}
+
+void BinaryTraceFormat::compress_block(const uint8_t* in, size_t n,
+                                       std::vector<uint8_t>& out) {
+    std::vector<uint32_t> table((size_t)1 << HASH_BITS, UINT32_MAX);
+    size_t literal_start = 0;
+    size_t i = 0;
+
+    while (i + MIN_MATCH <= n) {
+        uint32_t word;
+        std::memcpy(&word, in + i, 4);
+        uint32_t hash = (word * 2654435761u) >> (32 - HASH_BITS);
+        uint32_t candidate = table[hash];
+        table[hash] = (uint32_t)i;
+
+        if (candidate == UINT32_MAX || std::memcmp(in + candidate, in + i, MIN_MATCH) != 0) {
+            i++;
+            continue;
+        }
+
+        size_t length = MIN_MATCH;
+        while (i + length < n && in[candidate + length] == in[i + length])
+            length++;
+
+        put_varint(out, i - literal_start);
+        out.insert(out.end(), in + literal_start, in + i);
+        put_varint(out, length - MIN_MATCH + 1);
+        put_varint(out, i - candidate);
+
+        i += length;
+        literal_start = i;
+    }
+
+    // Trailing literals, then a zero match length ends the block
+    put_varint(out, n - literal_start);
+    out.insert(out.end(), in + literal_start, in + n);
+    put_varint(out, 0);
+}
+
+bool BinaryTraceFormat::decompress_block(const uint8_t* in, size_t n,
+                                         std::vector<uint8_t>& out, size_t raw_size) {
+    const uint8_t* p = in;
+    const uint8_t* end = in + n;
+    out.clear();
+    out.reserve(raw_size);
+
+    while (true) {
+        uint64_t literals, match;
+        if (!get_varint(p, end, literals) || (uint64_t)(end - p) < literals
+            || literals > raw_size - out.size())
+            return false;
+        out.insert(out.end(), p, p + literals);
+        p += literals;
+
+        if (!get_varint(p, end, match))
+            return false;
+        if (match == 0)
+            break;
+
+        uint64_t offset;
+        if (!get_varint(p, end, offset) || offset == 0 || offset > out.size())
+            return false;
+        // Checked before copying, so a corrupt length cannot grow the block
+        if (match + MIN_MATCH - 1 > raw_size - out.size())
+            return false;
+
+        // Byte by byte: a match may overlap the bytes it produces
+        size_t from = out.size() - offset;
+        for (uint64_t k = 0; k < match + MIN_MATCH - 1; ++k)
+            out.push_back(out[from + k]);
+    }
+
+    return out.size() == raw_size;
+}
+
+BinaryTraceWriter::BinaryTraceWriter()
+    : out(nullptr), compressed(false), last_address(0) {}
+
+BinaryTraceWriter::~BinaryTraceWriter() {
+    close();
+}
+
+bool BinaryTraceWriter::open(const std::string& path, bool compress) {
+    close();
+    out = std::fopen(path.c_str(), "wb");
+    if (!out)
+        return false;
+
+    compressed = compress;
+    last_address = 0;
+    block.clear();
+
+    uint8_t header[BinaryTraceFormat::HEADER_SIZE];
+    BinaryTraceFormat::write_header(header, compressed);
+    std::fwrite(header, 1, sizeof(header), out);
+    return true;
+}
+
+void BinaryTraceWriter::write(const TraceRecord& record) {
+    block.push_back((uint8_t)record.op | ((uint8_t)record.strategy << 4));
+
+    switch (record.op) {
+    case TraceOp::ACCESS:
+    case TraceOp::READ:
+    case TraceOp::WRITE:
+        put_varint(block, zigzag((int64_t)(record.value - last_address)));
+        last_address = record.value;
+        break;
+    case TraceOp::FREE:
+    case TraceOp::SLAB_FREE:
+        put_varint(block, zigzag((int64_t)record.value));
+        break;
+    case TraceOp::CONFIG:
+        put_varint(block, record.value);
+        block.insert(block.end(), record.text, record.text + record.value);
+        break;
+    default:
+        put_varint(block, record.value);
+        break;
+    }
+
+    if (block.size() >= BinaryTraceFormat::BLOCK_SIZE)
+        flush_block();
+}
+
+void BinaryTraceWriter::flush_block() {
+    if (block.empty())
+        return;
+
+    if (compressed) {
+        packed.clear();
+        BinaryTraceFormat::compress_block(block.data(), block.size(), packed);
+
+        std::vector<uint8_t> frame;
+        put_varint(frame, block.size());
+        put_varint(frame, packed.size());
+        std::fwrite(frame.data(), 1, frame.size(), out);
+        std::fwrite(packed.data(), 1, packed.size(), out);
+    } else {
+        std::fwrite(block.data(), 1, block.size(), out);
+    }
+
+    block.clear();
+}
+
+bool BinaryTraceWriter::close() {
+    if (!out)
+        return true;
+
+    flush_block();
+    if (compressed) {
+        uint8_t end_marker = 0;
+        std::fwrite(&end_marker, 1, 1, out);
+    }
+
+    bool ok = !std::ferror(out);
+    ok = std::fclose(out) == 0 && ok;
+    out = nullptr;
+    return ok;
+}
+
+BinaryTraceReader::BinaryTraceReader()
+    : compressed(false),
+      pos(nullptr), end(nullptr),
+      file_pos(nullptr), file_end(nullptr),
+      last_address(0),
+      corrupt(false) {}
+
+bool BinaryTraceReader::open(const std::string& path) {
+    if (!file.open(path) || !BinaryTraceFormat::is_binary_trace(file.data(), file.size()))
+        return false;
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(file.data());
+    if (data[4] == 0 || data[4] > BinaryTraceFormat::VERSION)
+        return false;
+
+    compressed = data[5] & BinaryTraceFormat::FLAG_COMPRESSED;
+    file_pos = data + BinaryTraceFormat::HEADER_SIZE;
+    file_end = data + file.size();
+    last_address = 0;
+    corrupt = false;
+    config_text.clear();
+
+    if (compressed) {
+        pos = end = nullptr;
+    } else {
+        pos = file_pos;
+        end = file_end;
+    }
+    return true;
+}
+
+bool BinaryTraceReader::load_block() {
+    uint64_t raw_size, packed_size;
+    if (!get_varint(file_pos, file_end, raw_size) || raw_size == 0)
+        return false;
+
+    if (!get_varint(file_pos, file_end, packed_size)
+        || (uint64_t)(file_end - file_pos) < packed_size
+        || !BinaryTraceFormat::decompress_block(file_pos, packed_size, block, raw_size)) {
+        corrupt = true;
+        return false;
+    }
+
+    file_pos += packed_size;
+    pos = block.data();
+    end = block.data() + block.size();
+    return true;
+}
+
+bool BinaryTraceReader::next(TraceRecord& record) {
+    if (pos == end && (!compressed || !load_block()))
+        return false;
+
+    uint8_t tag = *pos++;
+    uint64_t v;
+    if ((tag & 0x0f) > (uint8_t)TraceOp::CONFIG
+        || (tag >> 4) > (uint8_t)AllocStrategy::BUDDY
+        || !get_varint(pos, end, v)
+        || ((tag & 0x0f) == (uint8_t)TraceOp::CONFIG && (uint64_t)(end - pos) < v)) {
+        corrupt = true;
+        pos = end = nullptr;
+        file_pos = file_end;
+        return false;
+    }
+
+    record.op = (TraceOp)(tag & 0x0f);
+    record.strategy = (AllocStrategy)(tag >> 4);
+    record.text = nullptr;
+
+    switch (record.op) {
+    case TraceOp::ACCESS:
+    case TraceOp::READ:
+    case TraceOp::WRITE:
+        last_address += (uint64_t)unzigzag(v);
+        record.value = last_address;
+        break;
+    case TraceOp::FREE:
+    case TraceOp::SLAB_FREE:
+        record.value = (uint64_t)unzigzag(v);
+        break;
+    case TraceOp::CONFIG:
+        config_text.emplace_back(reinterpret_cast<const char*>(pos), v);
+        pos += v;
+        record.text = config_text.back().data();
+        record.value = v;
+        break;
+    default:
+        record.value = v;
+        break;
+    }
+
+    return true;
+}
@@ -0,0 +1,63 @@
+#include "trace/MappedFile.h"
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : data_ptr(nullptr), length(0), mapped(false) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+            data_ptr = static_cast<const char*>(p);
+            length = st.st_size;
+            mapped = true;
+            ::close(fd);
+            return true;
+        }
+    }
+    ::close(fd);
+#endif
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    buffer = contents.str();
+    data_ptr = buffer.data();
+    length = buffer.size();
+    return true;
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (mapped)
+        munmap(const_cast<char*>(data_ptr), length);
+#endif
+    data_ptr = nullptr;
+    length = 0;
+    mapped = false;
+    buffer.clear();
+}
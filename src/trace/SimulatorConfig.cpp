@@ -0,0 +1,321 @@
+#include "trace/SimulatorConfig.h"
+#include <cstdlib>
+#include <vector>
+
+static const char* const COMMANDS[] = {
+    "cores", "inclusion", "write_policy", "prefetch",
+    "vm_policy", "paging", "tlb", "numa"
+};
+
+SimulatorConfig::SimulatorConfig(CacheHierarchy& c,
+                                 VirtualMemoryManager& v,
+                                 std::streambuf* messages)
+    : caches(c),
+      vmm(v),
+      out(messages) {}
+
+// The hierarchy and the virtual memory must not keep the prefetchers or
+// the topology
+SimulatorConfig::~SimulatorConfig() {
+    for (size_t i = 0; i < prefetchers.size() && i < caches.num_levels(); ++i) {
+        if (prefetchers[i])
+            caches.set_prefetcher(i, nullptr);
+    }
+    if (numa) {
+        vmm.set_numa(nullptr);
+        caches.set_memory_model(nullptr);
+    }
+}
+
+bool SimulatorConfig::is_command(const std::string& name) {
+    for (const char* command : COMMANDS) {
+        if (name == command)
+            return true;
+    }
+    return false;
+}
+
+bool SimulatorConfig::apply(const std::string& line) {
+    std::istringstream args(line);
+    std::string cmd;
+    args >> cmd;
+
+    if (cmd == "cores")
+        return cores(args);
+    if (cmd == "inclusion")
+        return inclusion(args);
+    if (cmd == "write_policy")
+        return write_policy(args);
+    if (cmd == "prefetch")
+        return prefetch(args);
+    if (cmd == "vm_policy")
+        return vm_policy(args);
+    if (cmd == "paging")
+        return paging(args);
+    if (cmd == "tlb")
+        return tlb(args);
+    if (cmd == "numa")
+        return numa_command(args);
+    return false;
+}
+
+bool SimulatorConfig::cores(std::istringstream& args) {
+    size_t n;
+    args >> n;
+
+    if (!args) {
+        out << "Usage: cores <n>\n";
+        return false;
+    }
+
+    if (!caches.set_cores(n))
+        return false;
+    vmm.set_core(0);
+    out << "Running " << n << (n == 1 ? " core" : " cores") << " (caches emptied)\n";
+    return true;
+}
+
+bool SimulatorConfig::inclusion(std::istringstream& args) {
+    std::string name;
+    args >> name;
+
+    InclusionPolicy policy;
+    if (!args || !parse_inclusion_policy(name, policy)) {
+        out << "Usage: inclusion <inclusive|exclusive|nine>\n";
+        return false;
+    }
+
+    if (!caches.set_inclusion(policy))
+        return false;
+    out << "Cache hierarchy is now " << name << " (caches emptied)\n";
+    return true;
+}
+
+bool SimulatorConfig::write_policy(std::istringstream& args) {
+    std::string level, name, miss_name;
+    args >> level >> name >> miss_name;
+
+    WritePolicy policy;
+    WriteMissPolicy miss_policy;
+    int index = caches.find_level(level);
+    if (!args || index == -1 || !parse_write_policy(name, policy) ||
+        !parse_write_miss_policy(miss_name, miss_policy)) {
+        out << "Usage: write_policy <L1|L2> <write-back|write-through>"
+            << " <write-allocate|no-write-allocate>\n";
+        return false;
+    }
+
+    caches.set_write_policy(index, policy, miss_policy);
+    out << level << " is now " << name << ", " << miss_name << " (caches emptied)\n";
+    return true;
+}
+
+bool SimulatorConfig::prefetch(std::istringstream& args) {
+    std::string level, kind;
+    size_t degree = 1, distance = 1;
+    args >> level >> kind;
+
+    PrefetcherType type;
+    bool none = kind == "none";
+    int index = caches.find_level(level);
+    if (!args || index == -1 || (!none && !parse_prefetcher_type(kind, type))) {
+        out << "Usage: prefetch <L1|L2> <none|next-line|stride|stream> [degree] [distance]\n";
+        return false;
+    }
+
+    if (args >> degree)
+        args >> distance;
+
+    if (prefetchers.size() < caches.num_levels())
+        prefetchers.resize(caches.num_levels());
+    std::unique_ptr<Prefetcher>& slot = prefetchers[index];
+    if (none)
+        slot.reset();
+    else
+        slot.reset(new Prefetcher(type, degree, distance));
+    caches.set_prefetcher(index, slot.get());
+
+    if (none)
+        out << "Prefetcher removed from " << level << "\n";
+    else
+        out << "Attached " << kind << " prefetcher to " << level << " (degree "
+            << slot->get_degree() << ", distance " << slot->get_distance() << ")\n";
+    return true;
+}
+
+bool SimulatorConfig::vm_policy(std::istringstream& args) {
+    std::string name;
+    PageReplacementPolicy policy;
+    args >> name;
+
+    if (!parse_page_replacement_policy(name, policy)) {
+        out << "Usage: vm_policy <FIFO|LRU|CLOCK|SECOND_CHANCE|WSCLOCK> [window]\n";
+        return false;
+    }
+    if (policy == PageReplacementPolicy::OPT) {
+        out << "OPT needs the accesses to come: replay a trace with --vm-policy OPT\n";
+        return false;
+    }
+
+    size_t window;
+    if (args >> window)
+        vmm.set_wsclock_window(window);
+    vmm.set_policy(policy);
+    out << "Page replacement: " << page_replacement_policy_name(policy)
+        << " (resident pages released)\n";
+    return true;
+}
+
+bool SimulatorConfig::paging(std::istringstream& args) {
+    size_t levels, page_size, huge_page_size = 0, va_bits = PageTable::DEFAULT_VA_BITS;
+    args >> levels >> page_size;
+
+    if (!args) {
+        out << "Usage: paging <levels> <page_size> [huge_page_size] [va_bits]\n";
+        return false;
+    }
+    if (args >> huge_page_size)
+        args >> va_bits;
+
+    if (!vmm.set_paging(levels, page_size, huge_page_size, va_bits)) {
+        out << "Page tables need " << PageTable::MIN_LEVELS << "-" << PageTable::MAX_LEVELS
+            << " levels, a power-of-two page size that fits in memory and at most "
+            << PageTable::MAX_VA_BITS << "-bit addresses\n";
+        if (huge_page_size)
+            out << "Huge pages must be a power-of-two multiple of the page size"
+                << " that leaves every level at most "
+                << ((size_t)1 << PageTable::MAX_INDEX_BITS) << " entries\n";
+        return false;
+    }
+
+    out << levels << "-level page table with " << page_size << "-byte pages";
+    if (huge_page_size)
+        out << " and " << huge_page_size << "-byte huge pages";
+    if (va_bits != PageTable::DEFAULT_VA_BITS)
+        out << " over " << va_bits << "-bit addresses";
+    out << " (resident pages released)\n";
+    return true;
+}
+
+bool SimulatorConfig::tlb(std::istringstream& args) {
+    std::vector<std::string> words;
+    std::string word;
+    while (args >> word)
+        words.push_back(word);
+
+    std::vector<TlbLevelConfig> levels;
+    if (!(words.size() == 1 && words[0] == "off")) {
+        if (words.size() != 3 && words.size() != 6) {
+            out << "Usage: tlb <entries> <ways> <policy> [<entries> <ways> <policy>] | tlb off\n";
+            return false;
+        }
+        for (size_t i = 0; i < words.size(); i += 3) {
+            TlbLevelConfig level;
+            level.entries = std::strtoul(words[i].c_str(), nullptr, 10);
+            level.ways = std::strtoul(words[i + 1].c_str(), nullptr, 10);
+            level.policy = words[i + 2];
+            levels.push_back(level);
+        }
+    }
+
+    if (!vmm.set_tlb(levels)) {
+        out << "A TLB has at most two levels, each a multiple of its ways\n";
+        return false;
+    }
+
+    if (levels.empty())
+        out << "TLB removed\n";
+    else
+        out << levels.size() << "-level TLB per core\n";
+    return true;
+}
+
+bool SimulatorConfig::numa_command(std::istringstream& args) {
+    std::string mode;
+    args >> mode;
+
+    if (mode == "off") {
+        vmm.set_numa(nullptr);
+        caches.set_memory_model(nullptr);
+        numa.reset();
+        out << "NUMA off (resident pages released)\n";
+        return true;
+    }
+    if ((mode == "policy" || mode == "migrate" || mode == "latency") && !numa) {
+        out << "NUMA is off\n";
+        return false;
+    }
+
+    if (mode == "policy") {
+        std::string name;
+        size_t node = 0;
+        NumaPolicy policy;
+        args >> name;
+        if (!parse_numa_policy(name, policy) ||
+            (policy == NumaPolicy::BIND && !(args >> node))) {
+            out << "Usage: numa policy <first-touch|interleave|bind <node>>\n";
+            return false;
+        }
+        if (!vmm.set_numa_policy(policy, node)) {
+            out << "No node " << node << " (" << numa->num_nodes() << " nodes)\n";
+            return false;
+        }
+        out << "New pages placed " << numa_policy_name(policy);
+        if (policy == NumaPolicy::BIND)
+            out << " on node " << node;
+        out << "\n";
+        return true;
+    }
+
+    if (mode == "migrate") {
+        size_t threshold;
+        if (!(args >> threshold)) {
+            out << "Usage: numa migrate <threshold>\n";
+            return false;
+        }
+        vmm.set_numa_migration(threshold);
+        if (threshold)
+            out << "Pages migrate after " << threshold << " remote accesses in a row\n";
+        else
+            out << "Page migration off\n";
+        return true;
+    }
+
+    if (mode == "latency") {
+        size_t node, local, remote;
+        args >> node >> local >> remote;
+        if (!args) {
+            out << "Usage: numa latency <node> <local> <remote>\n";
+            return false;
+        }
+        if (!numa->set_latency(node, local, remote)) {
+            out << "No node " << node << " (" << numa->num_nodes() << " nodes)\n";
+            return false;
+        }
+        out << "Node " << node << ": " << local << " cycles local, " << remote << " remote\n";
+        return true;
+    }
+
+    std::istringstream count(mode);
+    size_t nodes = 0, local, remote;
+    count >> nodes;
+    args >> local >> remote;
+    if (!count || !args || nodes == 0 || nodes > NumaTopology::MAX_NODES) {
+        out << "Usage: numa <nodes> <local_latency> <remote_latency> (1-"
+            << NumaTopology::MAX_NODES << " nodes) | numa <policy|migrate|latency|off> ...\n";
+        return false;
+    }
+
+    size_t memory = vmm.get_total_memory();
+    std::unique_ptr<NumaTopology> topology(
+        new NumaTopology(nodes, memory / nodes, local, remote));
+    if (!vmm.set_numa(topology.get())) {
+        out << "Each node must hold at least one page\n";
+        return false;
+    }
+    caches.set_memory_model(topology.get());
+    numa = std::move(topology);
+    out << nodes << " NUMA nodes of " << numa->get_node_size() << " bytes, " << local
+        << " cycles local, " << remote << " remote (resident pages released)\n";
+    return true;
+}
@@ -0,0 +1,406 @@
+#include "trace/Sweep.h"
+#include "trace/BinaryTrace.h"
+#include "trace/SimulatorConfig.h"
+#include "trace/TextTraceReader.h"
+#include "trace/TraceReplayer.h"
+#include "cache/CacheHierarchy.h"
+#include "cache/Prefetcher.h"
+#include "MemoryManager.h"
+#include "SlabAllocator.h"
+#include "vm/VirtualMemoryManager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+const char* const SweepGrid::PARAMS[SweepGrid::NUM_PARAMS] = {
+    "block_size", "l1_size", "l1_assoc", "l1_policy", "l1_latency",
+    "l1_prefetcher", "l1_prefetch_degree", "l1_prefetch_distance",
+    "l2_size", "l2_assoc", "l2_policy", "l2_latency", "dram_latency",
+    "write_policy", "write_miss_policy",
+    "inclusion", "cores", "vm_memory", "vm_policy"
+};
+
+// The configuration main() builds
+static const char* const DEFAULTS[SweepGrid::NUM_PARAMS] = {
+    "64", "256", "2", "LRU", "1",
+    "none", "1", "1",
+    "1024", "4", "LRU", "10", "100",
+    "write-back", "write-allocate",
+    "nine", "1", "1024", "LRU"
+};
+
+enum SweepParam {
+    BLOCK_SIZE, L1_SIZE, L1_ASSOC, L1_POLICY, L1_LATENCY,
+    L1_PREFETCHER, L1_PREFETCH_DEGREE, L1_PREFETCH_DISTANCE,
+    L2_SIZE, L2_ASSOC, L2_POLICY, L2_LATENCY, DRAM_LATENCY,
+    WRITE_POLICY, WRITE_MISS_POLICY,
+    INCLUSION, CORES, VM_MEMORY, VM_POLICY
+};
+
+static bool is_number(const std::string& s) {
+    if (s.empty())
+        return false;
+    for (char c : s) {
+        if (c < '0' || c > '9')
+            return false;
+    }
+    return true;
+}
+
+static bool valid_value(size_t param, const std::string& value) {
+    ReplacementPolicy replacement;
+    InclusionPolicy inclusion;
+    PageReplacementPolicy page_policy;
+    PrefetcherType prefetcher;
+    WritePolicy write_policy;
+    WriteMissPolicy write_miss_policy;
+
+    switch (param) {
+    case L1_POLICY:
+    case L2_POLICY:
+        return parse_replacement_policy(value, replacement);
+    case L1_PREFETCHER:
+        return value == "none" || parse_prefetcher_type(value, prefetcher);
+    case WRITE_POLICY:
+        return parse_write_policy(value, write_policy);
+    case WRITE_MISS_POLICY:
+        return parse_write_miss_policy(value, write_miss_policy);
+    case INCLUSION:
+        return parse_inclusion_policy(value, inclusion);
+    case VM_POLICY:
+        // OPT needs the whole trace before the first access
+        return parse_page_replacement_policy(value, page_policy) &&
+               page_policy != PageReplacementPolicy::OPT;
+    case L1_LATENCY:
+    case L2_LATENCY:
+    case DRAM_LATENCY:
+        return is_number(value);
+    default:
+        return is_number(value) && std::stoull(value) > 0;
+    }
+}
+
+SweepGrid::SweepGrid() {
+    for (size_t p = 0; p < NUM_PARAMS; ++p)
+        axes.push_back(std::vector<std::string>(1, DEFAULTS[p]));
+}
+
+bool SweepGrid::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Cannot open grid " << path << "\n";
+        return false;
+    }
+
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(in, line)) {
+        line_number++;
+        std::stringstream ss(line);
+        std::string name;
+        if (!(ss >> name) || name[0] == '#')
+            continue;
+
+        size_t param = 0;
+        while (param < NUM_PARAMS && name != PARAMS[param])
+            param++;
+        if (param == NUM_PARAMS) {
+            std::cerr << path << ":" << line_number << ": unknown parameter " << name << "\n";
+            return false;
+        }
+
+        std::vector<std::string> values;
+        std::string value;
+        while (ss >> value) {
+            if (!valid_value(param, value)) {
+                std::cerr << path << ":" << line_number << ": bad value " << value
+                          << " for " << name << "\n";
+                return false;
+            }
+            values.push_back(value);
+        }
+
+        if (values.empty()) {
+            std::cerr << path << ":" << line_number << ": no values for " << name << "\n";
+            return false;
+        }
+        axes[param] = values;
+    }
+    return true;
+}
+
+size_t SweepGrid::size() const {
+    size_t total = 1;
+    for (const auto& axis : axes)
+        total *= axis.size();
+    return total;
+}
+
+// Mixed-radix digits of index, the last parameter varying fastest
+void SweepGrid::values(size_t index, std::vector<std::string>& out) const {
+    out.resize(NUM_PARAMS);
+    for (size_t p = NUM_PARAMS; p-- > 0;) {
+        out[p] = axes[p][index % axes[p].size()];
+        index /= axes[p].size();
+    }
+}
+
+SweepConfig SweepGrid::config(size_t index) const {
+    std::vector<std::string> v;
+    values(index, v);
+
+    SweepConfig c;
+    c.block_size = std::stoull(v[BLOCK_SIZE]);
+    c.l1_size = std::stoull(v[L1_SIZE]);
+    c.l1_assoc = std::stoull(v[L1_ASSOC]);
+    c.l1_policy = v[L1_POLICY];
+    c.l1_latency = std::stoull(v[L1_LATENCY]);
+    c.l1_prefetcher = v[L1_PREFETCHER];
+    c.l1_prefetch_degree = std::stoull(v[L1_PREFETCH_DEGREE]);
+    c.l1_prefetch_distance = std::stoull(v[L1_PREFETCH_DISTANCE]);
+    c.l2_size = std::stoull(v[L2_SIZE]);
+    c.l2_assoc = std::stoull(v[L2_ASSOC]);
+    c.l2_policy = v[L2_POLICY];
+    c.l2_latency = std::stoull(v[L2_LATENCY]);
+    c.dram_latency = std::stoull(v[DRAM_LATENCY]);
+    parse_write_policy(v[WRITE_POLICY], c.write_policy);
+    parse_write_miss_policy(v[WRITE_MISS_POLICY], c.write_miss_policy);
+    parse_inclusion_policy(v[INCLUSION], c.inclusion);
+    c.cores = std::stoull(v[CORES]);
+    c.vm_memory = std::stoull(v[VM_MEMORY]);
+    c.vm_policy = v[VM_POLICY];
+    return c;
+}
+
+// A complete simulator, as main() builds it, for one configuration
+struct SweepSimulation {
+    MemoryManager mm;
+    SlabAllocator slab;
+    std::unique_ptr<Prefetcher> prefetcher;     // outlives the L1 using it
+    CacheHierarchy caches;
+    VirtualMemoryManager vmm;
+    SimulatorConfig config;
+    TraceReplayer replayer;
+    bool valid;
+
+    explicit SweepSimulation(const SweepConfig& c)
+        : slab(mm),
+          caches(c.inclusion, c.dram_latency),
+          vmm(mm, caches, c.vm_memory, c.vm_policy),
+          config(caches, vmm, nullptr),
+          replayer(mm, slab, vmm) {
+
+        replayer.set_config(&config);
+
+        // Each level needs at least one set
+        if (c.l1_size < c.block_size * c.l1_assoc || c.l2_size < c.block_size * c.l2_assoc) {
+            std::cerr << "Skipping configuration: cache smaller than one set\n";
+            valid = false;
+            return;
+        }
+
+        valid = caches.add_level("L1", c.l1_size, c.block_size, c.l1_assoc, c.l1_policy,
+                                 c.l1_latency, c.write_policy, c.write_miss_policy)
+             && caches.add_level("L2", c.l2_size, c.block_size, c.l2_assoc, c.l2_policy,
+                                 c.l2_latency, c.write_policy, c.write_miss_policy)
+             && caches.set_cores(c.cores);
+
+        PrefetcherType type;
+        if (valid && parse_prefetcher_type(c.l1_prefetcher, type)) {
+            prefetcher.reset(new Prefetcher(type, c.l1_prefetch_degree, c.l1_prefetch_distance));
+            caches.set_prefetcher(0, prefetcher.get());
+        }
+    }
+};
+
+template <typename Reader>
+static void fill_chunk(Reader& reader, std::vector<TraceRecord>& chunk) {
+    TraceRecord record;
+    chunk.clear();
+    while (chunk.size() < SweepRunner::CHUNK_RECORDS && reader.next(record))
+        chunk.push_back(record);
+}
+
+// The calling thread decodes chunks; for each one it starts a round in
+// which every worker claims simulations from `next` and applies the whole
+// chunk to them. Rounds are separated by a barrier, so each simulation
+// sees the records in trace order.
+template <typename Reader>
+static void replay_chunks(Reader& reader,
+                          std::vector<std::unique_ptr<SweepSimulation>>& sims,
+                          size_t threads) {
+    std::vector<TraceRecord> chunks[2];
+    const std::vector<TraceRecord>* current = nullptr;
+    std::atomic<size_t> next(0);
+
+    std::mutex lock;
+    std::condition_variable start, finished;
+    size_t round = 0;
+    size_t busy = 0;
+    bool done = false;
+
+    auto work = [&]() {
+        size_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                start.wait(guard, [&] { return done || round != seen; });
+                if (done)
+                    return;
+                seen = round;
+            }
+
+            for (size_t i = next++; i < sims.size(); i = next++) {
+                SweepSimulation& sim = *sims[i];
+                if (!sim.valid)
+                    continue;
+                for (const TraceRecord& record : *current)
+                    sim.replayer.apply(record);
+            }
+
+            std::lock_guard<std::mutex> guard(lock);
+            if (--busy == 0)
+                finished.notify_one();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t)
+        workers.emplace_back(work);
+
+    size_t index = 0;
+    fill_chunk(reader, chunks[index]);
+    while (!chunks[index].empty()) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            current = &chunks[index];
+            next = 0;
+            busy = threads;
+            round++;
+        }
+        start.notify_all();
+
+        index ^= 1;
+        fill_chunk(reader, chunks[index]);
+
+        std::unique_lock<std::mutex> guard(lock);
+        finished.wait(guard, [&] { return busy == 0; });
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        done = true;
+    }
+    start.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+SweepRunner::SweepRunner(const SweepGrid& g, size_t t)
+    : grid(g),
+      threads(t) {
+
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+}
+
+size_t SweepRunner::num_threads() const {
+    return threads;
+}
+
+bool SweepRunner::run(const std::string& trace_path, std::vector<SweepResult>& results) {
+    BinaryTraceReader binary;
+    TextTraceReader text;
+    bool is_binary = binary.open(trace_path);
+    if (!is_binary && !text.open(trace_path)) {
+        std::cerr << "Cannot open trace " << trace_path << "\n";
+        return false;
+    }
+
+    std::vector<std::unique_ptr<SweepSimulation>> sims;
+    for (size_t i = 0; i < grid.size(); ++i)
+        sims.emplace_back(new SweepSimulation(grid.config(i)));
+
+    size_t workers = std::min(threads, sims.size());
+    if (is_binary)
+        replay_chunks(binary, sims, workers);
+    else
+        replay_chunks(text, sims, workers);
+
+    results.clear();
+    for (const auto& sim : sims) {
+        SweepResult r = SweepResult();
+        r.valid = sim->valid;
+        if (r.valid) {
+            r.records = sim->replayer.records();
+            r.l1_hit_rate = sim->caches.level(0).hit_rate();
+            r.l2_hit_rate = sim->caches.level(1).hit_rate();
+            r.amat = sim->caches.amat();
+            r.page_faults = sim->vmm.get_page_faults();
+            r.page_evictions = sim->vmm.get_page_evictions();
+        }
+        results.push_back(r);
+    }
+    return true;
+}
+
+void SweepRunner::write_csv(std::ostream& out, const SweepGrid& grid,
+                            const std::vector<SweepResult>& results) {
+    for (size_t p = 0; p < SweepGrid::NUM_PARAMS; ++p)
+        out << SweepGrid::PARAMS[p] << ",";
+    out << "valid,records,l1_hit_rate,l2_hit_rate,amat,page_faults,page_evictions\n";
+
+    std::vector<std::string> values;
+    for (size_t i = 0; i < results.size(); ++i) {
+        grid.values(i, values);
+        for (const std::string& value : values)
+            out << value << ",";
+
+        const SweepResult& r = results[i];
+        if (!r.valid) {
+            out << "0,,,,,,\n";
+            continue;
+        }
+        out << "1," << r.records << "," << r.l1_hit_rate << "," << r.l2_hit_rate << ","
+            << r.amat << "," << r.page_faults << "," << r.page_evictions << "\n";
+    }
+}
+
+void SweepRunner::write_json(std::ostream& out, const SweepGrid& grid,
+                             const std::vector<SweepResult>& results) {
+    std::vector<std::string> values;
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        grid.values(i, values);
+        out << "  {";
+        for (size_t p = 0; p < SweepGrid::NUM_PARAMS; ++p) {
+            out << "\"" << SweepGrid::PARAMS[p] << "\": ";
+            if (is_number(values[p]))
+                out << values[p] << ", ";
+            else
+                out << "\"" << values[p] << "\", ";
+        }
+
+        const SweepResult& r = results[i];
+        out << "\"valid\": " << (r.valid ? "true" : "false");
+        if (r.valid) {
+            out << ", \"records\": " << r.records
+                << ", \"l1_hit_rate\": " << r.l1_hit_rate
+                << ", \"l2_hit_rate\": " << r.l2_hit_rate
+                << ", \"amat\": " << r.amat
+                << ", \"page_faults\": " << r.page_faults
+                << ", \"page_evictions\": " << r.page_evictions;
+        }
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
@@ -0,0 +1,227 @@
+#include "trace/TextTraceReader.h"
+#include <cstring>
+
+static inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* skip_spaces(const char* p, const char* eol) {
+    while (p < eol && is_space(*p))
+        ++p;
+    return p;
+}
+
+// Reads one word; returns its length and advances p past it
+static inline size_t read_word(const char*& p, const char* eol) {
+    const char* start = p;
+    while (p < eol && !is_space(*p))
+        ++p;
+    return p - start;
+}
+
+static inline bool word_is(const char* word, size_t len, const char* literal) {
+    return std::strlen(literal) == len && std::memcmp(word, literal, len) == 0;
+}
+
+static bool word_in(const char* word, size_t len, const char* const* list) {
+    for (; *list; ++list) {
+        if (word_is(word, len, *list))
+            return true;
+    }
+    return false;
+}
+
+// Handled by SimulatorConfig
+static const char* const CONFIG_COMMANDS[] = {
+    "cores", "inclusion", "write_policy", "prefetch",
+    "vm_policy", "paging", "tlb", "numa", nullptr
+};
+
+// Interactive commands with effects a replay does not model
+static const char* const UNSUPPORTED_COMMANDS[] = {
+    "compact", "compaction", "fragmentation", "profile", "working_set",
+    "concurrent_init", "concurrent_alloc", "concurrent_free", nullptr
+};
+
+// Parses an optionally negative decimal integer
+static bool read_number(const char*& p, const char* eol, uint64_t& value) {
+    p = skip_spaces(p, eol);
+    bool negative = p < eol && *p == '-';
+    if (negative)
+        ++p;
+
+    const char* start = p;
+    uint64_t v = 0;
+    while (p < eol && *p >= '0' && *p <= '9')
+        v = v * 10 + (*p++ - '0');
+
+    if (p == start || (p < eol && !is_space(*p)))
+        return false;
+
+    value = negative ? (uint64_t)(-(int64_t)v) : v;
+    return true;
+}
+
+TextTraceReader::TextTraceReader()
+    : pos(nullptr), end(nullptr), line(0), skipped(0), unsupported(0), malformed(0) {}
+
+bool TextTraceReader::open(const std::string& path) {
+    if (!file.open(path))
+        return false;
+
+    pos = file.data();
+    end = file.data() + file.size();
+    line = 0;
+    skipped = 0;
+    unsupported = 0;
+    malformed = 0;
+    return true;
+}
+
+bool TextTraceReader::next(TraceRecord& record) {
+    while (pos < end) {
+        const char* eol = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+        if (!eol)
+            eol = end;
+
+        const char* p = pos;
+        pos = eol + 1;
+        line++;
+
+        p = skip_spaces(p, eol);
+        if (p == eol)
+            continue;
+
+        const char* word_end = p;
+        if (word_is(p, read_word(word_end, eol), "exit")) {
+            pos = end;
+            return false;
+        }
+
+        if (parse_line(p, eol, record))
+            return true;
+    }
+
+    pos = end;
+    return false;
+}
+
+bool TextTraceReader::parse_line(const char* p, const char* eol, TraceRecord& record) {
+    const char* cmd = p;
+    size_t len = read_word(p, eol);
+
+    record.strategy = AllocStrategy::FIRST_FIT;
+    record.text = nullptr;
+
+    // Arguments are checked when the record is applied
+    if (word_in(cmd, len, CONFIG_COMMANDS)) {
+        while (eol > cmd && is_space(eol[-1]))
+            --eol;
+        record.op = TraceOp::CONFIG;
+        record.text = cmd;
+        record.value = eol - cmd;
+        return true;
+    }
+    if (word_in(cmd, len, UNSUPPORTED_COMMANDS)) {
+        unsupported++;
+        return false;
+    }
+
+    switch (cmd[0]) {
+    case 'a':
+        if (word_is(cmd, len, "access")) {
+            record.op = TraceOp::ACCESS;
+            if (read_number(p, eol, record.value))
+                return true;
+        } else if (word_is(cmd, len, "alloc")) {
+            record.op = TraceOp::ALLOC;
+            p = skip_spaces(p, eol);
+            const char* strategy = p;
+            size_t slen = read_word(p, eol);
+
+            if (word_is(strategy, slen, "first"))
+                record.strategy = AllocStrategy::FIRST_FIT;
+            else if (word_is(strategy, slen, "best"))
+                record.strategy = AllocStrategy::BEST_FIT;
+            else if (word_is(strategy, slen, "worst"))
+                record.strategy = AllocStrategy::WORST_FIT;
+            else if (word_is(strategy, slen, "buddy"))
+                record.strategy = AllocStrategy::BUDDY;
+            else
+                break;
+
+            if (read_number(p, eol, record.value))
+                return true;
+        }
+        break;
+
+    case 'c':
+        if (word_is(cmd, len, "core")) {
+            record.op = TraceOp::CORE;
+            if (read_number(p, eol, record.value))
+                return true;
+        } else if (word_is(cmd, len, "cache_stats") || word_is(cmd, len, "concurrent_stats")) {
+            skipped++;
+            return false;
+        }
+        break;
+
+    case 'f':
+        if (word_is(cmd, len, "free")) {
+            record.op = TraceOp::FREE;
+            if (read_number(p, eol, record.value))
+                return true;
+        }
+        break;
+
+    case 'i':
+        if (word_is(cmd, len, "init")) {
+            record.op = TraceOp::INIT;
+            if (read_number(p, eol, record.value) && record.value != 0)
+                return true;
+        }
+        break;
+
+    case 'r':
+        if (word_is(cmd, len, "read")) {
+            record.op = TraceOp::READ;
+            if (read_number(p, eol, record.value))
+                return true;
+        }
+        break;
+
+    case 'w':
+        if (word_is(cmd, len, "write")) {
+            record.op = TraceOp::WRITE;
+            if (read_number(p, eol, record.value))
+                return true;
+        }
+        break;
+
+    case 's':
+        if (word_is(cmd, len, "slab_alloc")) {
+            record.op = TraceOp::SLAB_ALLOC;
+            if (read_number(p, eol, record.value))
+                return true;
+        } else if (word_is(cmd, len, "slab_free")) {
+            record.op = TraceOp::SLAB_FREE;
+            if (read_number(p, eol, record.value))
+                return true;
+        } else if (word_is(cmd, len, "stats") || word_is(cmd, len, "slab_stats")) {
+            skipped++;
+            return false;
+        }
+        break;
+
+    default:
+        if (word_is(cmd, len, "dump") || word_is(cmd, len, "help")
+            || word_is(cmd, len, "vm_stats")) {
+            skipped++;
+            return false;
+        }
+        break;
+    }
+
+    malformed++;
+    return false;
+}
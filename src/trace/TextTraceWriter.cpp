@@ -0,0 +1,63 @@
+#include "trace/TextTraceWriter.h"
+#include <cinttypes>
+
+TextTraceWriter::TextTraceWriter()
+    : out(nullptr) {}
+
+TextTraceWriter::~TextTraceWriter() {
+    close();
+}
+
+bool TextTraceWriter::open(const std::string& path) {
+    close();
+    out = std::fopen(path.c_str(), "w");
+    return out != nullptr;
+}
+
+void TextTraceWriter::write(const TraceRecord& record) {
+    static const char* const strategies[] = {"first", "best", "worst", "buddy"};
+
+    switch (record.op) {
+    case TraceOp::INIT:
+        std::fprintf(out, "init %" PRIu64 "\n", record.value);
+        break;
+    case TraceOp::ALLOC:
+        std::fprintf(out, "alloc %s %" PRIu64 "\n",
+                     strategies[(size_t)record.strategy], record.value);
+        break;
+    case TraceOp::FREE:
+        std::fprintf(out, "free %" PRId64 "\n", (int64_t)record.value);
+        break;
+    case TraceOp::ACCESS:
+        std::fprintf(out, "access %" PRIu64 "\n", record.value);
+        break;
+    case TraceOp::SLAB_ALLOC:
+        std::fprintf(out, "slab_alloc %" PRIu64 "\n", record.value);
+        break;
+    case TraceOp::SLAB_FREE:
+        std::fprintf(out, "slab_free %" PRId64 "\n", (int64_t)record.value);
+        break;
+    case TraceOp::READ:
+        std::fprintf(out, "read %" PRIu64 "\n", record.value);
+        break;
+    case TraceOp::WRITE:
+        std::fprintf(out, "write %" PRIu64 "\n", record.value);
+        break;
+    case TraceOp::CORE:
+        std::fprintf(out, "core %" PRIu64 "\n", record.value);
+        break;
+    case TraceOp::CONFIG:
+        std::fprintf(out, "%.*s\n", (int)record.value, record.text);
+        break;
+    }
+}
+
+bool TextTraceWriter::close() {
+    if (!out)
+        return true;
+
+    bool ok = !std::ferror(out);
+    ok = std::fclose(out) == 0 && ok;
+    out = nullptr;
+    return ok;
+}
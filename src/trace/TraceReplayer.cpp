@@ -0,0 +1,140 @@
+#include "trace/TraceReplayer.h"
+#include "trace/SimulatorConfig.h"
+#include <climits>
+#include <iostream>
+
+TraceReplayer::TraceReplayer(MemoryManager& m,
+                             SlabAllocator& s,
+                             VirtualMemoryManager& v)
+    : mm(m),
+      slab(s),
+      vmm(v),
+      config(nullptr),
+      initialized(false),
+      op_counts(),
+      failed_allocs(0),
+      invalid_frees(0),
+      invalid_cores(0),
+      rejected_configs(0),
+      uninitialized_ops(0) {
+
+    vmm.set_verbose(false);
+}
+
+void TraceReplayer::set_config(SimulatorConfig* c) {
+    config = c;
+}
+
+void TraceReplayer::apply(const TraceRecord& record) {
+    op_counts[(size_t)record.op]++;
+
+    switch (record.op) {
+    case TraceOp::INIT:
+        mm.init(record.value);
+        slab.reset();
+        initialized = true;
+        return;
+
+    case TraceOp::ACCESS:
+    case TraceOp::READ:
+        vmm.access(record.value);
+        return;
+
+    case TraceOp::WRITE:
+        vmm.access(record.value, AccessType::WRITE);
+        return;
+
+    case TraceOp::CORE:
+        if (!vmm.set_core(record.value))
+            invalid_cores++;
+        return;
+
+    case TraceOp::CONFIG:
+        if (!config || !config->apply(std::string(record.text, record.value)))
+            rejected_configs++;
+        return;
+
+    default:
+        break;
+    }
+
+    // Allocator commands need an initialized heap, as in interactive mode
+    if (!initialized) {
+        uninitialized_ops++;
+        return;
+    }
+
+    switch (record.op) {
+    case TraceOp::ALLOC: {
+        int id = -1;
+        switch (record.strategy) {
+        case AllocStrategy::FIRST_FIT: id = mm.allocate_first_fit(record.value); break;
+        case AllocStrategy::BEST_FIT:  id = mm.allocate_best_fit(record.value); break;
+        case AllocStrategy::WORST_FIT: id = mm.allocate_worst_fit(record.value); break;
+        case AllocStrategy::BUDDY:     id = mm.allocate_buddy(record.value); break;
+        }
+        if (id == -1)
+            failed_allocs++;
+        break;
+    }
+
+    case TraceOp::FREE:
+        // Slab blocks only go back through their slab cache; ids past INT_MAX
+        // were never handed out and must not wrap onto a live one
+        if (record.value > INT_MAX || slab.owns_block((int)record.value) ||
+            !mm.free_block((int)record.value))
+            invalid_frees++;
+        break;
+
+    case TraceOp::SLAB_ALLOC:
+        if (slab.allocate(record.value) == -1)
+            failed_allocs++;
+        break;
+
+    case TraceOp::SLAB_FREE:
+        if (record.value > INT_MAX || !slab.free((int)record.value))
+            invalid_frees++;
+        break;
+
+    default:
+        break;
+    }
+}
+
+bool TraceReplayer::is_initialized() const {
+    return initialized;
+}
+
+size_t TraceReplayer::records() const {
+    size_t total = 0;
+    for (size_t count : op_counts)
+        total += count;
+    return total;
+}
+
+void TraceReplayer::print_summary(double seconds) const {
+    std::cout << "--- Replay Summary ---\n";
+    std::cout << "Records: " << records() << "\n";
+    std::cout << "  init: " << op_counts[(size_t)TraceOp::INIT]
+              << ", alloc: " << op_counts[(size_t)TraceOp::ALLOC]
+              << ", free: " << op_counts[(size_t)TraceOp::FREE]
+              << ", access: " << op_counts[(size_t)TraceOp::ACCESS]
+              << ", read: " << op_counts[(size_t)TraceOp::READ]
+              << ", write: " << op_counts[(size_t)TraceOp::WRITE]
+              << ", slab_alloc: " << op_counts[(size_t)TraceOp::SLAB_ALLOC]
+              << ", slab_free: " << op_counts[(size_t)TraceOp::SLAB_FREE]
+              << ", core: " << op_counts[(size_t)TraceOp::CORE]
+              << ", config: " << op_counts[(size_t)TraceOp::CONFIG] << "\n";
+    std::cout << "Failed allocations: " << failed_allocs << "\n";
+    std::cout << "Invalid frees: " << invalid_frees << "\n";
+    if (invalid_cores)
+        std::cout << "Unknown cores: " << invalid_cores << "\n";
+    if (rejected_configs)
+        std::cout << "Rejected config commands: " << rejected_configs << "\n";
+    if (uninitialized_ops)
+        std::cout << "Skipped before init: " << uninitialized_ops << "\n";
+    std::cout << "Elapsed: " << seconds << " s";
+    if (seconds > 0)
+        std::cout << " (" << records() / seconds << " records/s)";
+    std::cout << "\n";
+}
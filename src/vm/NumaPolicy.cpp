@@ -0,0 +1,22 @@
+#include "vm/NumaPolicy.h"
+
+bool parse_numa_policy(const std::string& name, NumaPolicy& policy) {
+    if (name == "first-touch")
+        policy = NumaPolicy::FIRST_TOUCH;
+    else if (name == "interleave")
+        policy = NumaPolicy::INTERLEAVE;
+    else if (name == "bind")
+        policy = NumaPolicy::BIND;
+    else
+        return false;
+    return true;
+}
+
+const char* numa_policy_name(NumaPolicy policy) {
+    switch (policy) {
+    case NumaPolicy::FIRST_TOUCH: return "first-touch";
+    case NumaPolicy::INTERLEAVE:  return "interleave";
+    case NumaPolicy::BIND:        return "bind";
+    }
+    return "?";
+}
@@ -0,0 +1,99 @@
+#include "vm/NumaTopology.h"
+#include <iostream>
+
+NumaTopology::NumaTopology(size_t n, size_t size, size_t local_latency, size_t remote_latency)
+    : node_size(size),
+      nodes(n),
+      core_node(0) {
+
+    for (Node& node : nodes) {
+        node.memory.reset(new MemoryManager());
+        node.memory->init(node_size);
+        node.local_latency = local_latency;
+        node.remote_latency = remote_latency;
+    }
+    reset_stats();
+}
+
+size_t NumaTopology::num_nodes() const {
+    return nodes.size();
+}
+
+size_t NumaTopology::get_node_size() const {
+    return node_size;
+}
+
+size_t NumaTopology::total_size() const {
+    return nodes.size() * node_size;
+}
+
+MemoryManager& NumaTopology::memory(size_t node) {
+    return *nodes[node].memory;
+}
+
+size_t NumaTopology::base(size_t node) const {
+    return node * node_size;
+}
+
+size_t NumaTopology::node_of_address(size_t address) const {
+    size_t node = address / node_size;
+    return node < nodes.size() ? node : 0;
+}
+
+size_t NumaTopology::node_of_core(size_t core) const {
+    return core % nodes.size();
+}
+
+bool NumaTopology::set_latency(size_t node, size_t local_latency, size_t remote_latency) {
+    if (node >= nodes.size())
+        return false;
+    nodes[node].local_latency = local_latency;
+    nodes[node].remote_latency = remote_latency;
+    return true;
+}
+
+size_t NumaTopology::latency(size_t node, size_t from) const {
+    return node == from ? nodes[node].local_latency : nodes[node].remote_latency;
+}
+
+void NumaTopology::set_core(size_t core) {
+    core_node = node_of_core(core);
+}
+
+size_t NumaTopology::memory_latency(size_t address) {
+    size_t node = node_of_address(address);
+    if (node == core_node)
+        nodes[node].local_accesses++;
+    else
+        nodes[node].remote_accesses++;
+    return latency(node, core_node);
+}
+
+size_t NumaTopology::get_local_accesses(size_t node) const {
+    return nodes[node].local_accesses;
+}
+
+size_t NumaTopology::get_remote_accesses(size_t node) const {
+    return nodes[node].remote_accesses;
+}
+
+void NumaTopology::reset_stats() {
+    for (Node& node : nodes) {
+        node.local_accesses = 0;
+        node.remote_accesses = 0;
+    }
+}
+
+void NumaTopology::print_stats(const std::vector<size_t>& resident_pages) const {
+    for (size_t n = 0; n < nodes.size(); ++n) {
+        const Node& node = nodes[n];
+        size_t accesses = node.local_accesses + node.remote_accesses;
+        std::cout << "Node " << n << ": " << resident_pages[n] << " pages, latency "
+                  << node.local_latency << " local / " << node.remote_latency
+                  << " remote, memory accesses " << node.local_accesses << " local / "
+                  << node.remote_accesses << " remote";
+        if (accesses)
+            std::cout << " (" << 100.0 * node.remote_accesses / accesses << "% remote)";
+        std::cout << "\n";
+    }
+}
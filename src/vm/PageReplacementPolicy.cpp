@@ -0,0 +1,31 @@
+#include "vm/PageReplacementPolicy.h"
+
+bool parse_page_replacement_policy(const std::string& name, PageReplacementPolicy& policy) {
+    if (name == "FIFO")
+        policy = PageReplacementPolicy::FIFO;
+    else if (name == "LRU")
+        policy = PageReplacementPolicy::LRU;
+    else if (name == "CLOCK")
+        policy = PageReplacementPolicy::CLOCK;
+    else if (name == "SECOND_CHANCE")
+        policy = PageReplacementPolicy::SECOND_CHANCE;
+    else if (name == "WSCLOCK")
+        policy = PageReplacementPolicy::WSCLOCK;
+    else if (name == "OPT")
+        policy = PageReplacementPolicy::OPT;
+    else
+        return false;
+    return true;
+}
+
+const char* page_replacement_policy_name(PageReplacementPolicy policy) {
+    switch (policy) {
+    case PageReplacementPolicy::FIFO:          return "FIFO";
+    case PageReplacementPolicy::LRU:           return "LRU";
+    case PageReplacementPolicy::CLOCK:         return "CLOCK";
+    case PageReplacementPolicy::SECOND_CHANCE: return "SECOND_CHANCE";
+    case PageReplacementPolicy::WSCLOCK:       return "WSCLOCK";
+    case PageReplacementPolicy::OPT:           return "OPT";
+    }
+    return "?";
+}
@@ -0,0 +1,275 @@
+#include "vm/PageTable.h"
+#include <algorithm>
+
+static size_t log2_of(size_t n) {
+    size_t bits = 0;
+    while (((size_t)1 << bits) < n)
+        bits++;
+    return bits;
+}
+
+// Index widths for a geometry; false if some level would get no bits
+static bool split_vpn(size_t levels, size_t page_size, size_t huge_pages, size_t va_bits,
+                      size_t& root_bits, size_t& index_bits, size_t& leaf_bits) {
+    size_t offset_bits = log2_of(page_size);
+    if (va_bits > PageTable::MAX_VA_BITS || va_bits <= offset_bits)
+        return false;
+    size_t vpn_bits = va_bits - offset_bits;
+
+    size_t upper_bits = vpn_bits, upper_levels = levels;
+    if (huge_pages > 1) {
+        leaf_bits = log2_of(huge_pages);
+        if (leaf_bits > PageTable::MAX_INDEX_BITS || leaf_bits >= vpn_bits)
+            return false;
+        upper_bits -= leaf_bits;
+        upper_levels--;
+    }
+
+    index_bits = std::min((upper_bits + upper_levels - 1) / upper_levels,
+                          (size_t)PageTable::SPLIT_BITS);
+    if (huge_pages == 1)
+        leaf_bits = index_bits;
+    if (index_bits * (upper_levels - 1) >= upper_bits)
+        return false;
+    root_bits = std::min(upper_bits - index_bits * (upper_levels - 1),
+                         (size_t)PageTable::SPLIT_BITS);
+    return true;
+}
+
+PageTable::PageTable(size_t lv, size_t psize, size_t huge, size_t va)
+    : levels(lv),
+      page_size(psize),
+      huge_pages(huge),
+      va_bits(va),
+      next_phys(REGION_BASE),
+      live_nodes(0),
+      live_bytes(0),
+      free_nodes(lv) {
+
+    offset_bits = log2_of(page_size);
+    split_vpn(levels, page_size, huge_pages, va_bits, root_bits, index_bits, leaf_bits);
+    reach_bits = root_bits + index_bits * (levels - 2) + leaf_bits;
+
+    new_node(0);
+}
+
+bool PageTable::valid_geometry(size_t levels, size_t page_size, size_t huge_pages, size_t va_bits) {
+    if (levels < MIN_LEVELS || levels > MAX_LEVELS)
+        return false;
+    if (page_size < PTE_SIZE || (page_size & (page_size - 1)))
+        return false;
+    if (huge_pages == 0 || (huge_pages & (huge_pages - 1)))
+        return false;
+
+    size_t root_bits, index_bits, leaf_bits;
+    return split_vpn(levels, page_size, huge_pages, va_bits, root_bits, index_bits, leaf_bits);
+}
+
+size_t PageTable::index_width(size_t level) const {
+    if (level + 1 == levels)
+        return leaf_bits;
+    return level == 0 ? root_bits : index_bits;
+}
+
+size_t PageTable::index_at(size_t vpn, size_t level) const {
+    size_t shift = level + 1 == levels ? 0 : leaf_bits + index_bits * (levels - 2 - level);
+    return (vpn >> shift) & (((size_t)1 << index_width(level)) - 1);
+}
+
+bool PageTable::has_huge_entries(size_t level) const {
+    return huge_pages > 1 && level + 2 == levels;
+}
+
+// Nodes are laid out one after another in the page table region
+uint32_t PageTable::new_node(size_t level) {
+    size_t entries = (size_t)1 << index_width(level);
+    live_nodes++;
+    live_bytes += entries * PTE_SIZE;
+
+    if (!free_nodes[level].empty()) {
+        uint32_t node = free_nodes[level].back();
+        free_nodes[level].pop_back();
+        return node;
+    }
+
+    Node node;
+    if (level + 1 == levels || has_huge_entries(level))
+        node.entries.resize(entries);
+    if (level + 1 < levels)
+        node.children.assign(entries, 0);
+    node.phys_base = next_phys;
+    node.live = 0;
+    next_phys += entries * PTE_SIZE;
+
+    nodes.push_back(node);
+    return (uint32_t)(nodes.size() - 1);
+}
+
+// The node is empty, so it is already in the state new_node() hands out
+void PageTable::free_node(uint32_t node, size_t level) {
+    live_nodes--;
+    live_bytes -= ((size_t)1 << index_width(level)) * PTE_SIZE;
+    free_nodes[level].push_back(node);
+}
+
+uint32_t PageTable::root_of(size_t vpn, bool create) {
+    size_t top = vpn >> reach_bits;
+    if (top == 0)
+        return 0;
+
+    auto it = roots.find(top);
+    if (it != roots.end())
+        return it->second;
+    if (!create)
+        return NO_NODE;
+    uint32_t root = new_node(0);
+    roots[top] = root;
+    return root;
+}
+
+PageTableEntry& PageTable::walk(size_t vpn, size_t* walk) {
+    uint32_t node = root_of(vpn, true);
+
+    for (size_t level = 0; level + 1 < levels; ++level) {
+        size_t index = index_at(vpn, level);
+        if (walk)
+            walk[level] = nodes[node].phys_base + index * PTE_SIZE;
+        if (has_huge_entries(level) && nodes[node].entries[index].valid)
+            return nodes[node].entries[index];
+
+        if (!nodes[node].children[index]) {
+            uint32_t child = new_node(level + 1);
+            nodes[node].children[index] = child + 1;
+            nodes[node].live++;
+        }
+        node = nodes[node].children[index] - 1;
+    }
+
+    size_t index = index_at(vpn, levels - 1);
+    if (walk)
+        walk[levels - 1] = nodes[node].phys_base + index * PTE_SIZE;
+    return nodes[node].entries[index];
+}
+
+PageTableEntry* PageTable::find(size_t vpn) {
+    uint32_t node = root_of(vpn, false);
+    if (node == NO_NODE)
+        return nullptr;
+
+    for (size_t level = 0; level + 1 < levels; ++level) {
+        size_t index = index_at(vpn, level);
+        if (has_huge_entries(level) && nodes[node].entries[index].valid)
+            return &nodes[node].entries[index];
+
+        uint32_t child = nodes[node].children[index];
+        if (!child)
+            return nullptr;
+        node = child - 1;
+    }
+    return &nodes[node].entries[index_at(vpn, levels - 1)];
+}
+
+PageTableEntry& PageTable::map(size_t vpn) {
+    PageTableEntry& pte = walk(vpn, nullptr);
+    if (!pte.valid) {
+        pte.valid = true;
+
+        uint32_t node = root_of(vpn, false);
+        for (size_t level = 0; level + 1 < levels; ++level)
+            node = nodes[node].children[index_at(vpn, level)] - 1;
+        nodes[node].live++;
+    }
+    return pte;
+}
+
+void PageTable::unmap(size_t vpn) {
+    uint32_t path[MAX_LEVELS];
+    path[0] = root_of(vpn, false);
+    if (path[0] == NO_NODE)
+        return;
+    for (size_t level = 0; level + 1 < levels; ++level) {
+        size_t index = index_at(vpn, level);
+        // Huge pages are demoted before their pages are unmapped
+        if (has_huge_entries(level) && nodes[path[level]].entries[index].valid)
+            return;
+
+        uint32_t child = nodes[path[level]].children[index];
+        if (!child)
+            return;
+        path[level + 1] = child - 1;
+    }
+
+    PageTableEntry& pte = nodes[path[levels - 1]].entries[index_at(vpn, levels - 1)];
+    if (!pte.valid)
+        return;
+    pte = PageTableEntry();
+
+    // Release empty nodes bottom-up; the root always stays
+    size_t level = levels - 1;
+    while (level > 0 && --nodes[path[level]].live == 0) {
+        free_node(path[level], level);
+        nodes[path[level - 1]].children[index_at(vpn, level - 1)] = 0;
+        level--;
+    }
+}
+
+uint32_t PageTable::parent_of_leaf(size_t vpn) {
+    uint32_t node = root_of(vpn, false);
+    for (size_t level = 0; level + 2 < levels; ++level)
+        node = nodes[node].children[index_at(vpn, level)] - 1;
+    return node;
+}
+
+PageTableEntry& PageTable::promote(size_t vpn) {
+    uint32_t parent = parent_of_leaf(vpn);
+    size_t index = index_at(vpn, levels - 2);
+    uint32_t leaf = nodes[parent].children[index] - 1;
+
+    for (PageTableEntry& pte : nodes[leaf].entries)
+        pte = PageTableEntry();
+    nodes[leaf].live = 0;
+    free_node(leaf, levels - 1);
+    nodes[parent].children[index] = 0;
+
+    PageTableEntry& huge = nodes[parent].entries[index];
+    huge.valid = true;
+    huge.huge = true;
+    return huge;
+}
+
+void PageTable::demote(size_t vpn) {
+    uint32_t parent = parent_of_leaf(vpn);
+    size_t index = index_at(vpn, levels - 2);
+    nodes[parent].entries[index] = PageTableEntry();
+
+    uint32_t leaf = new_node(levels - 1);
+    nodes[parent].children[index] = leaf + 1;
+}
+
+bool PageTable::in_range(size_t virtual_address) const {
+    return va_bits >= MAX_VA_BITS || (virtual_address >> va_bits) == 0;
+}
+
+size_t PageTable::get_levels() const {
+    return levels;
+}
+
+size_t PageTable::get_page_size() const {
+    return page_size;
+}
+
+size_t PageTable::get_huge_pages() const {
+    return huge_pages;
+}
+
+size_t PageTable::get_va_bits() const {
+    return va_bits;
+}
+
+size_t PageTable::num_nodes() const {
+    return live_nodes;
+}
+
+size_t PageTable::table_bytes() const {
+    return live_bytes;
+}
@@ -0,0 +1,79 @@
+#include "vm/Tlb.h"
+#include <iostream>
+
+Tlb::Tlb()
+    : lookups(0),
+      misses(0),
+      total_cycles(0) {}
+
+bool Tlb::add_level(const std::string& name,
+                    size_t entries,
+                    size_t ways,
+                    const std::string& policy,
+                    size_t latency) {
+    if (ways == 0 || entries == 0 || entries % ways != 0) {
+        std::cerr << "Cannot add " << name << ": " << entries << " entries do not divide into "
+                  << ways << " ways\n";
+        return false;
+    }
+
+    std::unique_ptr<Cache> level(new Cache(entries, 1, ways, policy));
+    level->set_latency(latency);
+    level->set_memory_latency(0);
+
+    if (!levels.empty())
+        levels.back()->set_next_level(level.get());
+
+    levels.push_back(std::move(level));
+    names.push_back(name);
+    return true;
+}
+
+size_t Tlb::num_levels() const {
+    return levels.size();
+}
+
+bool Tlb::lookup(size_t vpn, size_t& cycles) {
+    lookups++;
+
+    bool hit = false;
+    for (auto& level : levels) {
+        bool dirty;
+        uint64_t touched;
+        if (level->probe(vpn, dirty, touched)) {
+            hit = true;
+            break;
+        }
+    }
+
+    cycles = levels.empty() ? 0 : levels.front()->access(vpn);
+    total_cycles += cycles;
+    if (!hit)
+        misses++;
+    return hit;
+}
+
+void Tlb::invalidate(size_t vpn) {
+    for (auto& level : levels)
+        level->snoop_invalidate(vpn);
+}
+
+void Tlb::reset() {
+    for (auto& level : levels)
+        level->reset();
+    lookups = 0;
+    misses = 0;
+    total_cycles = 0;
+}
+
+void Tlb::print_stats(const std::string& name) const {
+    std::cout << "--- " << name << " Stats ---\n";
+    for (size_t i = 0; i < levels.size(); ++i) {
+        std::cout << names[i] << " hits: " << levels[i]->get_hits()
+                  << ", misses: " << levels[i]->get_misses()
+                  << ", hit rate: " << levels[i]->hit_rate() << "\n";
+    }
+    std::cout << "Lookups: " << lookups << ", missed every level: " << misses << "\n";
+    if (lookups > 0)
+        std::cout << "Average lookup time: " << (double)total_cycles / lookups << " cycles\n";
+}
@@ -1,105 +1,871 @@
 #include "vm/VirtualMemoryManager.h"
 #include <iostream>
+#include <unordered_map>
 
 VirtualMemoryManager::VirtualMemoryManager(
     MemoryManager& mm,
-    Cache& l1,
+    CacheHierarchy& c,
     size_t total_memory,
-    const std::string& policy)
+    const std::string& policy_name)
     : phys_mem(mm),
-      cache(l1),
+      caches(c),
+      total_memory(total_memory),
+      page_size(DEFAULT_PAGE_SIZE),
+      used_frames(0),
       timestamp(0),
-      replacement_policy(policy),
-      page_faults(0),
-      page_evictions(0),
-      used_frames(0) {
+      core(0),
+      policy(PageReplacementPolicy::LRU),
+      wsclock_window(DEFAULT_WSCLOCK_WINDOW),
+      verbose(true),
+      profiler(nullptr),
+      working_set(nullptr),
+      page_table(DEFAULT_LEVELS, DEFAULT_PAGE_SIZE, 1, PageTable::MAX_VA_BITS),
+      oldest(NO_FRAME),
+      newest(NO_FRAME),
+      clock_hand(0),
+      future_pos(0),
+      unpopulated_slots(0),
+      spare_hand(0),
+      model_translation(false),
+      numa(nullptr),
+      numa_policy(NumaPolicy::FIRST_TOUCH),
+      bind_node(0),
+      migrate_after(0) {
 
-    max_frames = total_memory / PAGE_SIZE;
+    parse_page_replacement_policy(policy_name, policy);
+    max_frames = total_memory / page_size;
+    reset_stats();
+    phys_mem.set_relocation_listener(this);
 }
 
-int VirtualMemoryManager::allocate_frame() {
-    int block_id = phys_mem.allocate_first_fit(PAGE_SIZE);
-    if (block_id != -1) {
-        used_frames++;
+VirtualMemoryManager::~VirtualMemoryManager() {
+    if (phys_mem.get_relocation_listener() == this)
+        phys_mem.set_relocation_listener(nullptr);
+}
+
+void VirtualMemoryManager::on_relocate(int, size_t old_start, size_t, size_t size) {
+    relocations++;
+    relocation_cycles += caches.invalidate_range(old_start, size);
+}
+
+void VirtualMemoryManager::reset_stats() {
+    page_faults = 0;
+    page_evictions = 0;
+    page_writebacks = 0;
+    translations = 0;
+    walks = 0;
+    walk_references = 0;
+    walk_cycles = 0;
+    translation_cycles = 0;
+    out_of_range = 0;
+    promotions = 0;
+    demotions = 0;
+    failed_reservations = 0;
+    relocations = 0;
+    relocation_cycles = 0;
+    migrations = 0;
+    failed_migrations = 0;
+    migration_cycles = 0;
+    if (numa)
+        numa->reset_stats();
+    for (auto& tlb : tlbs)
+        tlb->reset();
+}
+
+uint32_t VirtualMemoryManager::new_frame() {
+    Frame frame;
+    frame.block_id = -1;
+    frame.block_offset = 0;
+    frame.reservation = NO_RESERVATION;
+    frame.node = 0;
+    frame.remote_node = 0;
+    frame.remote_accesses = 0;
+    frame.next_use = NEVER;
+    frames.push_back(frame);
+    used_frames++;
+    return (uint32_t)(frames.size() - 1);
+}
+
+void VirtualMemoryManager::bind_slot(uint32_t f, uint32_t r, size_t slot) {
+    Reservation& res = reservations[r];
+    frames[f].reservation = r;
+    frames[f].node = res.node;
+    frames[f].block_id = res.block_id;
+    frames[f].block_offset = slot * page_size;
+    res.slot_frames[slot] = f;
+    res.populated++;
+    unpopulated_slots--;
+}
+
+// Finds a frame for vpn and backing for it: a slot of the page's huge page
+// reservation if it gets one, otherwise a block of its own. Takes a
+// victim's frame when memory is full, and its backing when the allocator
+// is. Runs first touched while memory is full get no reservation, which
+// would only tie up memory the resident pages need.
+uint32_t VirtualMemoryManager::take_frame(size_t vpn) {
+    uint32_t f = NO_FRAME;
+    if (used_frames >= max_frames) {
+        if (oldest == NO_FRAME)
+            return NO_FRAME;
+        f = evict_page();
     }
-    return block_id;
+
+    uint32_t r = reserve(vpn, f == NO_FRAME);
+    if (r != NO_RESERVATION) {
+        if (f == NO_FRAME)
+            f = new_frame();
+        Frame old = frames[f];
+        bind_slot(f, r, vpn - reservations[r].base_vpn);
+
+        // After binding, so a victim from the same run keeps it reserved
+        if (old.block_id != -1)
+            release_backing(old);
+        return f;
+    }
+
+    uint32_t node = place(vpn);
+    if (f == NO_FRAME) {
+        int block_id = allocate_page(node);
+        if (block_id != -1) {
+            f = new_frame();
+            frames[f].block_id = block_id;
+            frames[f].node = node;
+            return f;
+        }
+
+        // Memory left to frames sits in other runs' reservations
+        size_t slot;
+        r = preempt_reservation(slot);
+        if (r != NO_RESERVATION) {
+            f = new_frame();
+            bind_slot(f, r, slot);
+            return f;
+        }
+        if (oldest == NO_FRAME)
+            return NO_FRAME;
+        f = evict_page();
+    }
+
+    if (frames[f].reservation != NO_RESERVATION)
+        break_reservation(frames[f].reservation);
+    else if (numa && frames[f].node != node)
+        rehome(f, node);
+    return f;
 }
 
-int VirtualMemoryManager::evict_page() {
-    size_t victim_vpn = 0;
+void VirtualMemoryManager::unlink(uint32_t f) {
+    Frame& frame = frames[f];
+    if (frame.prev == NO_FRAME)
+        oldest = frame.next;
+    else
+        frames[frame.prev].next = frame.next;
+    if (frame.next == NO_FRAME)
+        newest = frame.prev;
+    else
+        frames[frame.next].prev = frame.prev;
+}
 
-    if (replacement_policy == "FIFO") {
-        victim_vpn = fifo_queue.front();
-        fifo_queue.pop();
-    } else { 
-        size_t oldest_time = SIZE_MAX;
+void VirtualMemoryManager::push_newest(uint32_t f) {
+    frames[f].prev = newest;
+    frames[f].next = NO_FRAME;
+    if (newest == NO_FRAME)
+        oldest = f;
+    else
+        frames[newest].next = f;
+    newest = f;
+}
 
-        for (auto& entry : page_table) {
-            size_t vpn = entry.first;
-            PageTableEntry& pte = entry.second;
+// Every frame is resident whenever a victim is chosen
+uint32_t VirtualMemoryManager::select_victim() {
+    switch (policy) {
+    case PageReplacementPolicy::CLOCK:         return clock_victim();
+    case PageReplacementPolicy::SECOND_CHANCE: return second_chance_victim();
+    case PageReplacementPolicy::WSCLOCK:       return wsclock_victim();
+    case PageReplacementPolicy::OPT:           return std::prev(opt_order.end())->second;
+    default:                                   return oldest;
+    }
+}
+
+uint32_t VirtualMemoryManager::clock_victim() {
+    while (true) {
+        uint32_t f = clock_hand;
+        clock_hand = (clock_hand + 1) % frames.size();
+
+        PageTableEntry* pte = page_table.find(frames[f].vpn);
+        if (!pte->referenced)
+            return f;
+        pte->referenced = false;
+    }
+}
 
-            if (pte.valid && pte.last_used < oldest_time) {
-                oldest_time = pte.last_used;
-                victim_vpn = vpn;
-            }
+uint32_t VirtualMemoryManager::second_chance_victim() {
+    while (true) {
+        uint32_t f = oldest;
+        PageTableEntry* pte = page_table.find(frames[f].vpn);
+        if (!pte->referenced)
+            return f;
+
+        pte->referenced = false;
+        unlink(f);
+        push_newest(f);
+    }
+}
+
+// Takes the first clean page at the hand that is neither referenced nor
+// used within the window. Dirty pages outside the window are written back
+// as the hand passes. If a whole revolution finds nothing, every page is
+// in the working set and the least recently used clean page goes, or the
+// least recently used page if all are dirty.
+uint32_t VirtualMemoryManager::wsclock_victim() {
+    uint32_t clean = NO_FRAME, any = NO_FRAME;
+    size_t clean_used = NEVER, any_used = NEVER;
+
+    for (size_t step = 0; step < frames.size(); ++step) {
+        uint32_t f = clock_hand;
+        clock_hand = (clock_hand + 1) % frames.size();
+
+        PageTableEntry* pte = page_table.find(frames[f].vpn);
+        if (pte->referenced) {
+            pte->referenced = false;
+        } else if (timestamp - pte->last_used > wsclock_window) {
+            if (!pte->dirty)
+                return f;
+            pte->dirty = false;
+            page_writebacks++;
+        }
+
+        if (pte->last_used < any_used) {
+            any = f;
+            any_used = pte->last_used;
+        }
+        if (!pte->dirty && pte->last_used < clean_used) {
+            clean = f;
+            clean_used = pte->last_used;
         }
     }
+    return clean != NO_FRAME ? clean : any;
+}
 
-    PageTableEntry& victim = page_table[victim_vpn];
-    int block_id = victim.block_id;
+uint32_t VirtualMemoryManager::evict_page() {
+    uint32_t f = select_victim();
+    size_t victim_vpn = frames[f].vpn;
 
-    phys_mem.free_block(block_id);
+    // Only part of a huge page goes
+    PageTableEntry* pte = page_table.find(victim_vpn);
+    if (pte->huge) {
+        demote(pte->frame);
+        pte = page_table.find(victim_vpn);
+    }
+
+    if (pte->dirty)
+        page_writebacks++;
 
-    victim.valid = false;
-    used_frames--;
+    unlink(f);
+    if (policy == PageReplacementPolicy::OPT)
+        opt_order.erase(std::make_pair(frames[f].next_use, f));
+    page_table.unmap(victim_vpn);
+    for (auto& tlb : tlbs)
+        tlb->invalidate(victim_vpn);
     page_evictions++;
 
-    return block_id;
+    return f;
+}
+
+uint32_t VirtualMemoryManager::reserve(size_t vpn, bool create) {
+    size_t huge_pages = page_table.get_huge_pages();
+    if (huge_pages == 1)
+        return NO_RESERVATION;
+
+    size_t run = vpn / huge_pages;
+    auto it = reservation_of.find(run);
+    if (it != reservation_of.end())
+        return it->second;
+    if (!create || used_frames + unpopulated_slots + huge_pages > max_frames)
+        return NO_RESERVATION;
+
+    // Interleaving goes by huge page
+    uint32_t node = place(vpn);
+    if (numa && numa_policy == NumaPolicy::INTERLEAVE)
+        node = (uint32_t)(run % numa->num_nodes());
+
+    size_t bytes = huge_pages * page_size;
+    int block_id = memory(node).allocate_aligned(bytes, bytes);
+    if (block_id == -1) {
+        failed_reservations++;
+        return NO_RESERVATION;
+    }
+
+    uint32_t r;
+    if (free_reservations.empty()) {
+        r = (uint32_t)reservations.size();
+        reservations.emplace_back();
+    } else {
+        r = free_reservations.back();
+        free_reservations.pop_back();
+    }
+
+    Reservation& res = reservations[r];
+    res.base_vpn = run * huge_pages;
+    res.block_id = block_id;
+    res.node = node;
+    res.populated = 0;
+    res.broken = false;
+    res.promoted = false;
+    res.slot_frames.assign(huge_pages, (uint32_t)NO_FRAME);
+    reservation_of[run] = r;
+    unpopulated_slots += huge_pages;
+    return r;
+}
+
+void VirtualMemoryManager::release_backing(const Frame& frame) {
+    uint32_t r = frame.reservation;
+    if (r == NO_RESERVATION) {
+        memory(frame.node).free_block(frame.block_id);
+        return;
+    }
+
+    Reservation& res = reservations[r];
+    res.slot_frames[frame.block_offset / page_size] = NO_FRAME;
+    unpopulated_slots++;
+    if (--res.populated > 0)
+        return;
+
+    memory(res.node).free_block(res.block_id);
+    unpopulated_slots -= res.slot_frames.size();
+    if (!res.broken)
+        reservation_of.erase(res.base_vpn / res.slot_frames.size());
+    res.block_id = -1;
+    free_reservations.push_back(r);
+}
+
+// The run can no longer become a huge page; its later faults get pages of
+// their own
+void VirtualMemoryManager::break_reservation(uint32_t r) {
+    Reservation& res = reservations[r];
+    if (res.broken)
+        return;
+    res.broken = true;
+    reservation_of.erase(res.base_vpn / res.slot_frames.size());
+}
+
+// Breaks a reservation with an empty slot, which slot receives, so a page
+// of another run can use it. Keeps draining the same reservation before
+// moving on to the next, clock-style.
+uint32_t VirtualMemoryManager::preempt_reservation(size_t& slot) {
+    for (size_t n = 0; n < reservations.size(); ++n) {
+        if (spare_hand >= reservations.size())
+            spare_hand = 0;
+        Reservation& res = reservations[spare_hand];
+        if (res.block_id == -1 || res.populated == res.slot_frames.size()) {
+            spare_hand++;
+            continue;
+        }
+
+        break_reservation(spare_hand);
+        for (slot = 0; res.slot_frames[slot] != NO_FRAME; ++slot)
+            ;
+        return spare_hand;
+    }
+    return NO_RESERVATION;
+}
+
+// Huge entries carry one set of bits for the whole page
+void VirtualMemoryManager::promote(uint32_t r) {
+    Reservation& res = reservations[r];
+    size_t huge_pages = res.slot_frames.size();
+
+    PageTableEntry merged;
+    merged.loaded_at = NEVER;
+    for (size_t slot = 0; slot < huge_pages; ++slot) {
+        const PageTableEntry* pte = page_table.find(res.base_vpn + slot);
+        merged.referenced |= pte->referenced;
+        merged.dirty |= pte->dirty;
+        merged.loaded_at = std::min(merged.loaded_at, pte->loaded_at);
+        merged.last_used = std::max(merged.last_used, pte->last_used);
+    }
+
+    PageTableEntry& huge = page_table.promote(res.base_vpn);
+    huge.block_id = res.block_id;
+    huge.frame = r;
+    huge.referenced = merged.referenced;
+    huge.dirty = merged.dirty;
+    huge.loaded_at = merged.loaded_at;
+    huge.last_used = merged.last_used;
+
+    res.promoted = true;
+    promotions++;
+    for (auto& tlb : tlbs) {
+        for (size_t slot = 0; slot < huge_pages; ++slot)
+            tlb->invalidate(res.base_vpn + slot);
+    }
+}
+
+void VirtualMemoryManager::demote(uint32_t r) {
+    Reservation& res = reservations[r];
+    size_t huge_pages = res.slot_frames.size();
+    PageTableEntry huge = *page_table.find(res.base_vpn);
+
+    page_table.demote(res.base_vpn);
+    for (size_t slot = 0; slot < huge_pages; ++slot) {
+        PageTableEntry& pte = page_table.map(res.base_vpn + slot);
+        pte.block_id = res.block_id;
+        pte.block_offset = slot * page_size;
+        pte.frame = res.slot_frames[slot];
+        pte.referenced = huge.referenced;
+        pte.dirty = huge.dirty;
+        pte.loaded_at = huge.loaded_at;
+        pte.last_used = huge.last_used;
+    }
+
+    res.promoted = false;
+    demotions++;
+    for (auto& tlb : tlbs)
+        tlb->invalidate(huge_key(res.base_vpn));
+}
+
+// Huge pages share the TLBs with base pages under keys of their own
+size_t VirtualMemoryManager::huge_key(size_t vpn) const {
+    return ((size_t)1 << 62) | (vpn / page_table.get_huge_pages());
+}
+
+size_t VirtualMemoryManager::memory_size() const {
+    return numa ? numa->total_size() : total_memory;
+}
+
+MemoryManager& VirtualMemoryManager::memory(uint32_t node) {
+    return numa ? numa->memory(node) : phys_mem;
+}
+
+size_t VirtualMemoryManager::phys_address(uint32_t node, int block_id, size_t offset) {
+    size_t base = numa ? numa->base(node) : 0;
+    return base + memory(node).get_block_start(block_id) + offset;
+}
+
+uint32_t VirtualMemoryManager::place(size_t vpn) const {
+    if (!numa)
+        return 0;
+    switch (numa_policy) {
+    case NumaPolicy::INTERLEAVE: return (uint32_t)(vpn % numa->num_nodes());
+    case NumaPolicy::BIND:       return bind_node;
+    default:                     return (uint32_t)numa->node_of_core(core);
+    }
+}
+
+// A page's backing on node, or on the other nodes in turn when it is full
+// unless the policy binds; node receives where it went
+int VirtualMemoryManager::allocate_page(uint32_t& node) {
+    int block_id = memory(node).allocate_first_fit(page_size);
+    if (block_id != -1 || !numa || numa_policy == NumaPolicy::BIND)
+        return block_id;
+
+    for (uint32_t other = 0; other < numa->num_nodes(); ++other) {
+        if (other == node)
+            continue;
+        block_id = numa->memory(other).allocate_first_fit(page_size);
+        if (block_id != -1) {
+            node = other;
+            return block_id;
+        }
+    }
+    return -1;
+}
+
+// A victim's frame on another node than the page taking it over: the page
+// moves to its own node if that has room
+void VirtualMemoryManager::rehome(uint32_t f, uint32_t node) {
+    Frame& frame = frames[f];
+    int block_id = numa->memory(node).allocate_first_fit(page_size);
+    if (block_id == -1)
+        return;
+
+    numa->memory(frame.node).free_block(frame.block_id);
+    frame.block_id = block_id;
+    frame.node = node;
+}
+
+// Accesses from the page's own node reset the count. After migrate_after
+// accesses in a row from one remote node the page moves there: its lines
+// are written back and dropped, then it is copied a line at a time.
+void VirtualMemoryManager::count_remote(uint32_t f, PageTableEntry& pte) {
+    Frame& frame = frames[f];
+    uint32_t node = (uint32_t)numa->node_of_core(core);
+    if (node == frame.node) {
+        frame.remote_accesses = 0;
+        return;
+    }
+    if (node != frame.remote_node) {
+        frame.remote_node = node;
+        frame.remote_accesses = 0;
+    }
+    if (++frame.remote_accesses < migrate_after)
+        return;
+    frame.remote_accesses = 0;
+
+    int block_id = numa->memory(node).allocate_first_fit(page_size);
+    if (block_id == -1) {
+        failed_migrations++;
+        return;
+    }
+
+    size_t old_start = phys_address(frame.node, frame.block_id, 0);
+    size_t line = caches.num_levels() ? caches.level(0).get_block_size() : page_size;
+    migration_cycles += caches.invalidate_range(old_start, page_size);
+    migration_cycles += (page_size + line - 1) / line *
+                        (numa->latency(frame.node, node) + numa->latency(node, node));
+
+    numa->memory(frame.node).free_block(frame.block_id);
+    frame.block_id = block_id;
+    frame.node = node;
+    pte.block_id = block_id;
+    migrations++;
+}
+
+// Moves a resident frame, or places a newly loaded one, in OPT's order
+void VirtualMemoryManager::set_next_use(uint32_t f, size_t next) {
+    opt_order.erase(std::make_pair(frames[f].next_use, f));
+    frames[f].next_use = next;
+    opt_order.insert(std::make_pair(next, f));
+}
+
+Tlb* VirtualMemoryManager::core_tlb() {
+    if (tlb_config.empty())
+        return nullptr;
+
+    while (tlbs.size() <= core) {
+        std::unique_ptr<Tlb> tlb(new Tlb());
+        for (size_t i = 0; i < tlb_config.size(); ++i) {
+            const TlbLevelConfig& level = tlb_config[i];
+            tlb->add_level(i == 0 ? "L1 TLB" : "L2 TLB", level.entries, level.ways,
+                           level.policy, i == 0 ? Tlb::L1_LATENCY : Tlb::L2_LATENCY);
+        }
+        tlbs.push_back(std::move(tlb));
+    }
+    return tlbs[core].get();
 }
 
-void VirtualMemoryManager::access(size_t virtual_address) {
+// A TLB miss reads one entry per level, root first, through the data
+// caches of the issuing core
+PageTableEntry& VirtualMemoryManager::translate(size_t vpn) {
+    if (!model_translation)
+        return page_table.walk(vpn, nullptr);
+
+    translations++;
+    size_t cycles = 0;
+    Tlb* tlb = core_tlb();
+    if (tlb) {
+        // Both page sizes are looked up at once
+        size_t key = vpn;
+        if (page_table.get_huge_pages() > 1) {
+            const PageTableEntry* mapped = page_table.find(vpn);
+            if (mapped && mapped->huge)
+                key = huge_key(vpn);
+        }
+        if (tlb->lookup(key, cycles)) {
+            translation_cycles += cycles;
+            return page_table.walk(vpn, nullptr);
+        }
+    }
+
+    size_t walk[PageTable::MAX_LEVELS];
+    PageTableEntry& pte = page_table.walk(vpn, walk);
+    size_t levels = pte.huge ? page_table.get_levels() - 1 : page_table.get_levels();
+    walks++;
+    for (size_t level = 0; level < levels; ++level) {
+        if (profiler)
+            profiler->access(walk[level]);
+        size_t latency = caches.access(walk[level], AccessType::READ, core);
+        walk_references++;
+        walk_cycles += latency;
+        cycles += latency;
+    }
+    translation_cycles += cycles;
+    return pte;
+}
+
+void VirtualMemoryManager::access(size_t virtual_address, AccessType type) {
     timestamp++;
 
-    size_t vpn = virtual_address / PAGE_SIZE;
-    size_t offset = virtual_address % PAGE_SIZE;
+    size_t next = NEVER;
+    if (policy == PageReplacementPolicy::OPT && future_pos < next_use.size())
+        next = next_use[future_pos];
+    future_pos++;
+
+    if (!page_table.in_range(virtual_address)) {
+        out_of_range++;
+        if (verbose)
+            std::cout << "[OUT OF RANGE] Virtual address " << virtual_address << "\n";
+        return;
+    }
+
+    size_t vpn = virtual_address / page_size;
+    size_t offset = virtual_address % page_size;
 
-    auto& pte = page_table[vpn];
+    auto& pte = translate(vpn);
 
     if (pte.valid) {
         pte.last_used = timestamp;
+        pte.referenced = true;
+        if (type == AccessType::WRITE)
+            pte.dirty = true;
 
-        size_t phys_addr =
-            phys_mem.get_block_start(pte.block_id) + offset;
+        uint32_t f = pte.frame;
+        size_t block_offset = pte.block_offset;
+        if (pte.huge) {
+            size_t slot = vpn % page_table.get_huge_pages();
+            f = reservations[pte.frame].slot_frames[slot];
+            block_offset = slot * page_size;
+        }
+
+        if (policy == PageReplacementPolicy::LRU && f != newest) {
+            unlink(f);
+            push_newest(f);
+        } else if (policy == PageReplacementPolicy::OPT) {
+            set_next_use(f, next);
+        }
+
+        if (numa && migrate_after && !pte.huge && frames[f].reservation == NO_RESERVATION)
+            count_remote(f, pte);
+
+        size_t phys_addr = phys_address(frames[f].node, pte.block_id, block_offset + offset);
 //std::cout << "Phys addr: " << phys_addr << "\n";
-        cache.access(phys_addr);
+        if (working_set)
+            working_set->record(vpn, false, used_frames);
+        if (profiler)
+            profiler->access(phys_addr);
+        caches.access(phys_addr, type, core);
         return;
     }
 
     page_faults++;
-    std::cout << "[PAGE FAULT] Virtual page " << vpn << "\n";
-
-    int block_id;
+    if (verbose)
+        std::cout << "[PAGE FAULT] Virtual page " << vpn << "\n";
 
-    if (used_frames < max_frames) {
-        block_id = allocate_frame();
-    } else {
-        block_id = evict_page();
+    uint32_t frame = take_frame(vpn);
+    if (frame == NO_FRAME) {
+        std::cerr << "No frame available for virtual page " << vpn << "\n";
+        return;
     }
 
-    pte.block_id = block_id;
-    pte.valid = true;
-    pte.loaded_at = timestamp;
-    pte.last_used = timestamp;
+    frames[frame].vpn = vpn;
+    push_newest(frame);
+    if (policy == PageReplacementPolicy::OPT)
+        set_next_use(frame, next);
 
-    if (replacement_policy == "FIFO") {
-        fifo_queue.push(vpn);
-    }
+    // The eviction may have released the node that pte pointed into
+    PageTableEntry& mapped = page_table.map(vpn);
+    const Frame& backing = frames[frame];
+    mapped.block_id = backing.block_id;
+    mapped.block_offset = backing.block_offset;
+    mapped.frame = frame;
+    mapped.loaded_at = timestamp;
+    mapped.last_used = timestamp;
+    mapped.referenced = true;
+    mapped.dirty = type == AccessType::WRITE;
 
     size_t phys_addr =
-        phys_mem.get_block_start(block_id) + offset;
+        phys_address(backing.node, backing.block_id, backing.block_offset + offset);
+
+    uint32_t r = backing.reservation;
+    if (r != NO_RESERVATION && !reservations[r].broken &&
+        reservations[r].populated == reservations[r].slot_frames.size())
+        promote(r);
    // std::cout << "Phys addr: " << phys_addr << "\n";
 
-    cache.access(phys_addr);
+    if (working_set)
+        working_set->record(vpn, true, used_frames);
+    if (profiler)
+        profiler->access(phys_addr);
+    caches.access(phys_addr, type, core);
+}
+
+void VirtualMemoryManager::set_verbose(bool on) {
+    verbose = on;
+}
+
+bool VirtualMemoryManager::set_core(size_t c) {
+    if (c >= caches.num_cores())
+        return false;
+    core = c;
+    return true;
+}
+
+size_t VirtualMemoryManager::get_core() const {
+    return core;
+}
+
+void VirtualMemoryManager::set_profiler(StackDistanceProfiler* p) {
+    profiler = p;
+}
+
+void VirtualMemoryManager::set_working_set_tracker(WorkingSetTracker* tracker) {
+    working_set = tracker;
+}
+
+void VirtualMemoryManager::release_frames() {
+    for (const Frame& frame : frames) {
+        if (frame.reservation == NO_RESERVATION)
+            memory(frame.node).free_block(frame.block_id);
+    }
+    for (const Reservation& res : reservations) {
+        if (res.block_id != -1)
+            memory(res.node).free_block(res.block_id);
+    }
+    frames.clear();
+    reservations.clear();
+    free_reservations.clear();
+    reservation_of.clear();
+    unpopulated_slots = 0;
+    spare_hand = 0;
+    oldest = NO_FRAME;
+    newest = NO_FRAME;
+    clock_hand = 0;
+    opt_order.clear();
+
+    used_frames = 0;
+    timestamp = 0;
+
+    // Cached translations refer to the old pages
+    tlbs.clear();
+    reset_stats();
+}
+
+bool VirtualMemoryManager::set_paging(size_t levels, size_t psize, size_t huge_size, size_t va_bits) {
+    size_t huge_pages = huge_size ? huge_size / psize : 1;
+    if (huge_size && (huge_size <= psize || huge_size % psize != 0))
+        return false;
+    if (!PageTable::valid_geometry(levels, psize, huge_pages, va_bits) || psize > total_memory)
+        return false;
+    if (numa && psize > numa->get_node_size())
+        return false;
+
+    release_frames();
+    page_table = PageTable(levels, psize, huge_pages, va_bits);
+    page_size = psize;
+    max_frames = memory_size() / page_size;
+    model_translation = true;
+
+    // Next uses were computed for the old page size
+    compute_next_use();
+    return true;
+}
+
+void VirtualMemoryManager::set_policy(PageReplacementPolicy p) {
+    release_frames();
+    page_table = PageTable(page_table.get_levels(), page_size, page_table.get_huge_pages(),
+                           page_table.get_va_bits());
+    policy = p;
+}
+
+PageReplacementPolicy VirtualMemoryManager::get_policy() const {
+    return policy;
+}
+
+void VirtualMemoryManager::set_wsclock_window(size_t window) {
+    wsclock_window = window;
+}
+
+void VirtualMemoryManager::set_future(const std::vector<size_t>& virtual_addresses) {
+    future = virtual_addresses;
+    compute_next_use();
+    future_pos = 0;
+}
+
+void VirtualMemoryManager::compute_next_use() {
+    next_use.assign(future.size(), (size_t)NEVER);
+
+    std::unordered_map<size_t, size_t> following;
+    for (size_t i = future.size(); i-- > 0;) {
+        size_t vpn = future[i] / page_size;
+        auto inserted = following.emplace(vpn, i);
+        if (!inserted.second) {
+            next_use[i] = inserted.first->second;
+            inserted.first->second = i;
+        }
+    }
+}
+
+bool VirtualMemoryManager::set_tlb(const std::vector<TlbLevelConfig>& levels) {
+    if (levels.size() > 2)
+        return false;
+
+    Tlb check;
+    for (const TlbLevelConfig& level : levels) {
+        if (!check.add_level("TLB", level.entries, level.ways, level.policy, 0))
+            return false;
+    }
+
+    tlb_config = levels;
+    tlbs.clear();
+    model_translation = true;
+    return true;
+}
+
+bool VirtualMemoryManager::set_numa(NumaTopology* n) {
+    if (n && page_size > n->get_node_size())
+        return false;
+
+    release_frames();
+    page_table = PageTable(page_table.get_levels(), page_size, page_table.get_huge_pages(),
+                           page_table.get_va_bits());
+    numa = n;
+    numa_policy = NumaPolicy::FIRST_TOUCH;
+    bind_node = 0;
+    migrate_after = 0;
+    max_frames = memory_size() / page_size;
+    reset_stats();
+    return true;
+}
+
+bool VirtualMemoryManager::set_numa_policy(NumaPolicy policy, size_t node) {
+    if (!numa || (policy == NumaPolicy::BIND && node >= numa->num_nodes()))
+        return false;
+    numa_policy = policy;
+    bind_node = policy == NumaPolicy::BIND ? (uint32_t)node : 0;
+    return true;
+}
+
+void VirtualMemoryManager::set_numa_migration(size_t threshold) {
+    migrate_after = threshold;
+}
+
+size_t VirtualMemoryManager::get_migrations() const {
+    return migrations;
+}
+
+size_t VirtualMemoryManager::get_total_memory() const {
+    return total_memory;
+}
+
+size_t VirtualMemoryManager::get_page_faults() const {
+    return page_faults;
+}
+
+size_t VirtualMemoryManager::get_page_evictions() const {
+    return page_evictions;
+}
+
+size_t VirtualMemoryManager::get_page_writebacks() const {
+    return page_writebacks;
+}
+
+size_t VirtualMemoryManager::get_page_walks() const {
+    return walks;
+}
+
+double VirtualMemoryManager::average_translation_time() const {
+    return translations ? (double)translation_cycles / translations : 0.0;
+}
+
+size_t VirtualMemoryManager::get_promotions() const {
+    return promotions;
+}
+
+size_t VirtualMemoryManager::get_demotions() const {
+    return demotions;
+}
+
+size_t VirtualMemoryManager::reserved_unpopulated_bytes() const {
+    return unpopulated_slots * page_size;
 }
 
 void VirtualMemoryManager::print_stats() const {
@@ -107,4 +873,56 @@ void VirtualMemoryManager::print_stats() const {
     std::cout << "Page faults: " << page_faults << "\n";
     std::cout << "Page evictions: " << page_evictions << "\n";
     std::cout << "Resident pages: " << used_frames << "\n";
+    if (page_writebacks > 0)
+        std::cout << "Dirty page writebacks: " << page_writebacks << "\n";
+    if (out_of_range > 0)
+        std::cout << "Out-of-range addresses: " << out_of_range << "\n";
+    if (relocations > 0) {
+        std::cout << "Relocated blocks: " << relocations << " (" << relocation_cycles
+                  << " cycles writing back their cached lines)\n";
+    }
+    if (numa) {
+        std::vector<size_t> pages(numa->num_nodes(), 0);
+        for (const Frame& frame : frames)
+            pages[frame.node]++;
+
+        std::cout << "NUMA: " << numa->num_nodes() << " nodes, "
+                  << numa_policy_name(numa_policy) << " placement";
+        if (numa_policy == NumaPolicy::BIND)
+            std::cout << " on node " << bind_node;
+        if (migrate_after)
+            std::cout << ", migration after " << migrate_after << " remote accesses";
+        std::cout << "\n";
+        numa->print_stats(pages);
+        if (migrate_after) {
+            std::cout << "Page migrations: " << migrations << " (" << failed_migrations
+                      << " failed, " << migration_cycles << " cycles copying)\n";
+        }
+    }
+    if (!model_translation)
+        return;
+
+    std::cout << "Page table: " << page_table.get_levels() << " levels, " << page_size
+              << "-byte pages, " << page_table.num_nodes() << " nodes ("
+              << page_table.table_bytes() << " bytes)\n";
+    if (page_table.get_huge_pages() > 1) {
+        size_t huge = 0, active = 0;
+        for (const Reservation& res : reservations) {
+            active += res.block_id != -1;
+            huge += res.block_id != -1 && res.promoted;
+        }
+        std::cout << "Huge pages (" << page_table.get_huge_pages() * page_size << " bytes): "
+                  << huge << " resident, promotions: " << promotions
+                  << ", demotions: " << demotions << "\n";
+        std::cout << "Reservations: " << active << " active, " << reserved_unpopulated_bytes()
+                  << " bytes reserved but unpopulated, " << failed_reservations << " failed\n";
+    }
+    std::cout << "Translations: " << translations << ", page walks: " << walks
+              << " (" << walk_references << " references, " << walk_cycles << " cycles)\n";
+    if (translations > 0)
+        std::cout << "Average translation time: " << (double)translation_cycles / translations
+                  << " cycles\n";
+
+    for (size_t i = 0; i < tlbs.size(); ++i)
+        tlbs[i]->print_stats(tlbs.size() == 1 ? "TLB" : "TLB core " + std::to_string(i));
 }
@@ -0,0 +1,220 @@
+#include "vm/WorkingSetTracker.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// splitmix64 finalizer: consecutive page numbers spread over all registers
+static uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+static size_t bucket_of(size_t distance) {
+    return distance ? 64 - __builtin_clzll(distance) : 0;
+}
+
+WorkingSetTracker::WorkingSetTracker(const std::vector<size_t>& w, size_t iv)
+    : interval(iv ? iv : DEFAULT_INTERVAL),
+      registers((size_t)1 << REGISTER_BITS),
+      reuse(1, std::vector<size_t>(1, 1)) {
+
+    for (size_t window : w) {
+        if (window)
+            windows.push_back(window);
+    }
+    if (windows.empty())
+        windows.push_back(interval);
+    std::sort(windows.begin(), windows.end());
+    windows.erase(std::unique(windows.begin(), windows.end()), windows.end());
+    reset();
+}
+
+void WorkingSetTracker::reset() {
+    for (auto& marks : registers)
+        marks.clear();
+    reuse.reset();
+    time = 0;
+    interval_faults = 0;
+    total_faults = 0;
+    samples.clear();
+}
+
+void WorkingSetTracker::record(size_t vpn, bool fault, size_t resident) {
+    time++;
+    if (fault) {
+        interval_faults++;
+        total_faults++;
+    }
+
+    uint64_t h = mix(vpn);
+    std::deque<Mark>& marks = registers[h >> (64 - REGISTER_BITS)];
+    uint64_t rest = h << REGISTER_BITS;
+    uint8_t rank = rest ? (uint8_t)(__builtin_clzll(rest) + 1) : (uint8_t)(65 - REGISTER_BITS);
+
+    // Older marks of no higher rank can never be a maximum again
+    while (!marks.empty() && marks.back().rank <= rank)
+        marks.pop_back();
+    marks.push_back({time, rank});
+    while (marks.front().time + windows.back() <= time)
+        marks.pop_front();
+
+    // Blocks of one byte make line numbers page numbers
+    reuse.access(vpn);
+
+    if (time % interval == 0)
+        take_sample(resident);
+}
+
+double WorkingSetTracker::working_set(size_t window) const {
+    window = std::min(window, windows.back());
+    const double m = (double)registers.size();
+
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (const auto& marks : registers) {
+        uint8_t rank = 0;
+        for (const Mark& mark : marks) {
+            if (mark.time + window > time) {
+                rank = mark.rank;
+                break;
+            }
+        }
+        sum += std::ldexp(1.0, -(int)rank);
+        zeros += rank == 0;
+    }
+
+    // Linear counting while registers are still empty
+    double estimate = 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0)
+        estimate = m * std::log(m / zeros);
+    return estimate;
+}
+
+void WorkingSetTracker::take_sample(size_t resident) {
+    Sample sample;
+    sample.time = time;
+    sample.accesses = samples.empty() ? time : time - samples.back().time;
+    sample.faults = interval_faults;
+    sample.resident = resident;
+    for (size_t window : windows)
+        sample.working_sets.push_back(working_set(window));
+    samples.push_back(sample);
+    interval_faults = 0;
+}
+
+const std::vector<size_t>& WorkingSetTracker::get_windows() const {
+    return windows;
+}
+
+size_t WorkingSetTracker::get_interval() const {
+    return interval;
+}
+
+uint64_t WorkingSetTracker::total_accesses() const {
+    return time;
+}
+
+size_t WorkingSetTracker::num_samples() const {
+    return samples.size();
+}
+
+void WorkingSetTracker::reuse_buckets(std::vector<uint64_t>& buckets, uint64_t& cold) const {
+    std::vector<uint64_t> histogram;
+    reuse.distance_histogram(1, histogram, cold);
+
+    buckets.clear();
+    for (size_t d = 0; d < histogram.size(); ++d) {
+        if (!histogram[d])
+            continue;
+        size_t b = bucket_of(d);
+        if (b >= buckets.size())
+            buckets.resize(b + 1, 0);
+        buckets[b] += histogram[d];
+    }
+}
+
+static void print_bucket(std::ostream& out, size_t b) {
+    if (b == 0)
+        out << "0";
+    else if (b == 1)
+        out << "1";
+    else
+        out << ((size_t)1 << (b - 1)) << "-" << ((size_t)1 << b) - 1;
+}
+
+void WorkingSetTracker::print_stats() const {
+    std::cout << "--- Working Set Stats ---\n";
+    std::cout << "Accesses: " << time << ", page faults: " << total_faults
+              << ", samples: " << samples.size() << " (every " << interval << " accesses)\n";
+    if (time == 0)
+        return;
+
+    std::cout << "Working set now:";
+    for (size_t window : windows)
+        std::cout << " W(" << window << ") = " << std::round(working_set(window));
+    std::cout << " pages\n";
+
+    std::vector<uint64_t> buckets;
+    uint64_t cold;
+    reuse_buckets(buckets, cold);
+    std::cout << "Page reuse distances:\n";
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        if (!buckets[b])
+            continue;
+        std::cout << "  ";
+        print_bucket(std::cout, b);
+        std::cout << ": " << buckets[b] << "\n";
+    }
+    std::cout << "  first use: " << cold << "\n";
+}
+
+void WorkingSetTracker::write_csv(std::ostream& out) const {
+    out << "time,accesses,faults,fault_rate,resident";
+    for (size_t window : windows)
+        out << ",ws_" << window;
+    out << "\n";
+
+    for (const Sample& s : samples) {
+        out << s.time << "," << s.accesses << "," << s.faults << ","
+            << (double)s.faults / s.accesses << "," << s.resident;
+        for (double ws : s.working_sets)
+            out << "," << ws;
+        out << "\n";
+    }
+}
+
+void WorkingSetTracker::write_json(std::ostream& out) const {
+    out << "{\n  \"interval\": " << interval << ",\n  \"windows\": [";
+    for (size_t i = 0; i < windows.size(); ++i)
+        out << (i ? ", " : "") << windows[i];
+    out << "],\n  \"samples\": [\n";
+
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const Sample& s = samples[i];
+        out << "    {\"time\": " << s.time << ", \"accesses\": " << s.accesses
+            << ", \"faults\": " << s.faults
+            << ", \"fault_rate\": " << (double)s.faults / s.accesses
+            << ", \"resident\": " << s.resident << ", \"working_sets\": [";
+        for (size_t w = 0; w < s.working_sets.size(); ++w)
+            out << (w ? ", " : "") << s.working_sets[w];
+        out << "]}" << (i + 1 < samples.size() ? "," : "") << "\n";
+    }
+
+    std::vector<uint64_t> buckets;
+    uint64_t cold;
+    reuse_buckets(buckets, cold);
+    out << "  ],\n  \"reuse_distance\": {\"first_use\": " << cold << ", \"buckets\": [";
+    bool first = true;
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        if (!buckets[b])
+            continue;
+        size_t low = b ? (size_t)1 << (b - 1) : 0;
+        size_t high = b ? ((size_t)1 << b) - 1 : 0;
+        out << (first ? "" : ", ") << "{\"min\": " << low << ", \"max\": " << high
+            << ", \"count\": " << buckets[b] << "}";
+        first = false;
+    }
+    out << "]}\n}\n";
+}